@@ -1,6 +1,14 @@
 #!/usr/bin/env bash
 set -e
 mkdir -p build bin
-g++ -std=gnu++17 -O2 src/main.cpp src/graph.cpp src/io.cpp src/planner.cpp -I src -o bin/route_planner
-g++ -std=gnu++17 -O2 src/batch_runner.cpp src/graph.cpp src/io.cpp src/planner.cpp -I src -o bin/batch_runner
-echo "Built bin/route_planner and bin/batch_runner"
+# extra compiler flags, e.g. CXXFLAGS="-DROUTE_INSTRUMENT -DROUTE_TRACE" ./build.sh
+CXXFLAGS="${CXXFLAGS:-}"
+CORE="src/graph.cpp src/snapshot.cpp src/reorder.cpp src/mapped_file.cpp src/io.cpp src/planner.cpp src/ch.cpp src/landmarks.cpp src/parallel.cpp src/spatial_index.cpp src/result_cache.cpp src/synthetic.cpp src/instrumentation.cpp src/latency_histogram.cpp src/time_profiles.cpp src/graph_updates.cpp src/delta_stepping.cpp src/isochrone.cpp"
+g++ -std=gnu++17 -O2 $CXXFLAGS src/main.cpp $CORE -I src -pthread -o bin/route_planner
+g++ -std=gnu++17 -O2 $CXXFLAGS src/batch_runner.cpp $CORE -I src -pthread -o bin/batch_runner
+g++ -std=gnu++17 -O2 $CXXFLAGS src/snapshot_convert.cpp src/graph.cpp src/snapshot.cpp src/reorder.cpp src/mapped_file.cpp -I src -pthread -o bin/snapshot_convert
+g++ -std=gnu++17 -O2 $CXXFLAGS src/route_server.cpp $CORE -I src -pthread -o bin/route_server
+g++ -std=gnu++17 -O2 $CXXFLAGS src/route_bench.cpp $CORE -I src -pthread -o bin/route_bench
+g++ -std=gnu++17 -O2 $CXXFLAGS src/graph_gen.cpp $CORE -I src -pthread -o bin/graph_gen
+g++ -std=gnu++17 -O2 $CXXFLAGS src/route_loadgen.cpp -I src -pthread -o bin/route_loadgen
+echo "Built bin/route_planner, bin/batch_runner, bin/snapshot_convert, bin/route_server, bin/route_bench, bin/graph_gen and bin/route_loadgen"
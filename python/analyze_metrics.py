@@ -1,6 +1,7 @@
 # analyze_metrics.py
 # reads results/metrics.csv or results/metrics_batch.csv and outputs summary: mean, median, p90, p99
-import sys, csv, statistics
+# also reads the latency histograms of results/latency_histogram.csv (label,low_ns,high_ns,count)
+import sys, csv, math, statistics
 
 def read_metric(file):
     data = {}
@@ -14,6 +15,38 @@ def read_metric(file):
             data[label]['times'].append(int(float(row['millis'])))
     return data
 
+def read_histograms(file):
+    hists = {}
+    with open(file) as f:
+        r = csv.DictReader(f)
+        for row in r:
+            hists.setdefault(row['label'], []).append((int(row['low_ns']), int(row['high_ns']), int(row['count'])))
+    return hists
+
+def hist_pct(buckets, p):
+    # same rule as LatencyHistogram::percentile: upper edge of the bucket holding the ceil(p*n)-th sample,
+    # clamped to the recorded range (the CSV narrows the first and last bucket to min and max)
+    if not buckets: return 0
+    buckets = sorted(buckets)
+    lo, hi = buckets[0][0], buckets[-1][1]
+    total = sum(c for _,_,c in buckets)
+    rank = max(1, math.ceil(p/100.0*total))
+    seen = 0
+    for low, high, c in buckets:
+        seen += c
+        if seen >= rank: return max(lo, min(high, hi))
+    return hi
+
+def summarize_histograms(hists):
+    for k, buckets in hists.items():
+        total = sum(c for _,_,c in buckets)
+        mean = sum((low+high)/2*c for low,high,c in buckets)/total if total else 0
+        print(k, "count=", total)
+        print(" mean latency us= %.2f" % (mean/1000))
+        print(" p50=", hist_pct(buckets,50), "p90=", hist_pct(buckets,90), "p99=", hist_pct(buckets,99),
+              "p99.9=", hist_pct(buckets,99.9), "max=", max(h for _,h,_ in buckets), "(ns)")
+        print()
+
 def pct(v,p):
     v=sorted(v)
     if not v: return 0
@@ -24,8 +57,13 @@ def pct(v,p):
 
 if __name__=='__main__':
     if len(sys.argv)<2:
-        print("Usage: python analyze_metrics.py results/metrics_batch.csv")
+        print("Usage: python analyze_metrics.py results/metrics_batch.csv | results/latency_histogram.csv")
         sys.exit(1)
+    with open(sys.argv[1]) as f:
+        header = f.readline()
+    if 'low_ns' in header:
+        summarize_histograms(read_histograms(sys.argv[1]))
+        sys.exit(0)
     data = read_metric(sys.argv[1])
     for k,v in data.items():
         times = v['times']
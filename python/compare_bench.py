@@ -0,0 +1,36 @@
+# compare_bench.py
+# compares two route_bench (or Google Benchmark) JSON files by the mean time per benchmark
+# exits with 1 when a benchmark got slower than the threshold, e.g. for a CI gate
+import sys, json
+
+def read_means(file):
+    with open(file) as f:
+        doc = json.load(f)
+    means = {}
+    for b in doc.get('benchmarks', []):
+        if b.get('run_type') == 'aggregate' and b.get('aggregate_name') == 'mean':
+            means[b['run_name']] = (b['real_time'], b.get('time_unit', 'ns'))
+    return means
+
+if __name__=='__main__':
+    if len(sys.argv)<3:
+        print("Usage: python compare_bench.py baseline.json current.json [threshold=0.10]")
+        sys.exit(1)
+    base = read_means(sys.argv[1])
+    cur = read_means(sys.argv[2])
+    threshold = float(sys.argv[3]) if len(sys.argv)>3 else 0.10
+    regressions = 0
+    print("%-44s %14s %14s %9s" % ("Benchmark", "baseline", "current", "change"))
+    for name in sorted(set(base) & set(cur)):
+        b, unit = base[name]
+        c, _ = cur[name]
+        change = (c - b) / b if b > 0 else 0.0
+        flag = ""
+        if change > threshold:
+            flag = "  SLOWER"
+            regressions += 1
+        print("%-44s %12.1f%-2s %12.1f%-2s %+8.1f%%%s" % (name, b, unit, c, unit, change*100, flag))
+    for name in sorted(set(base) - set(cur)): print("%-44s missing in current" % name)
+    for name in sorted(set(cur) - set(base)): print("%-44s new" % name)
+    print(regressions, "benchmark(s) slower than", "%.0f%%" % (threshold*100))
+    sys.exit(1 if regressions else 0)
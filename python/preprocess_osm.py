@@ -4,6 +4,10 @@ Extract a road graph using osmnx and write nodes and edges CSV
 Requires: osmnx, networkx, pandas
 Usage:
   python preprocess_osm.py --place "Pune, India" --outdir data
+  python preprocess_osm.py --place "Pune, India" --outdir data --directed
+With --directed one-way streets are kept (load the CSVs with --directed);
+routes.csv always carries length (m) and travel_time (s) columns, the
+second one usable through --metric travel_time.
 Or:
   python preprocess_osm.py --pbf path/to/file.pbf --bbox minx miny maxx maxy --outdir data
 """
@@ -28,13 +32,14 @@ def graph_to_csv(G, outdir):
         nodes.append((nid, lat, lon, name))
     nodes_df = pd.DataFrame(nodes, columns=['id','lat','lon','name'])
     nodes_df.to_csv(os.path.join(outdir,'cities.csv'), index=False)
-    # edges.csv (undirected; combine multiple edges)
+    # edges.csv: one row per (directed or undirected) edge, parallel edges kept
     edges = []
     for u,v,data in G.edges(data=True):
         length = data.get('length')
         if length is None: length = data.get('weight',1.0)
-        edges.append((u,v,length))
-    edges_df = pd.DataFrame(edges, columns=['u','v','w'])
+        travel_time = data.get('travel_time', length)
+        edges.append((u,v,length,travel_time))
+    edges_df = pd.DataFrame(edges, columns=['u','v','length','travel_time'])
     edges_df.to_csv(os.path.join(outdir,'routes.csv'), index=False)
     print("Wrote", outdir)
 
@@ -43,14 +48,18 @@ def main():
     parser.add_argument('--place', type=str, help='place name for osmnx to geocode (e.g. "Pune, India")')
     parser.add_argument('--pbf', type=str, help='optional pbf file (not used in this script)')
     parser.add_argument('--outdir', type=str, default='data')
+    parser.add_argument('--directed', action='store_true', help='keep one-way streets as directed edges')
     args = parser.parse_args()
     if args.place:
         print("Downloading graph for", args.place)
         G = ox.graph_from_place(args.place, network_type='drive')
         G = ox.simplify_graph(G)
-        # convert MultiDiGraph to undirected simple graph with lengths
-        Gu = ox.get_undirected(G)
-        graph_to_csv(Gu, args.outdir)
+        G = ox.add_edge_speeds(G)
+        G = ox.add_edge_travel_times(G)
+        if not args.directed:
+            # convert MultiDiGraph to undirected graph with lengths
+            G = ox.get_undirected(G)
+        graph_to_csv(G, args.outdir)
     else:
         print("Please supply --place 'City, Country'")
         return
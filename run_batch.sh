@@ -12,3 +12,4 @@ SEED="${2:-12345}"
 echo "Running batch runner: numq=$NUMQ seed=$SEED"
 bin/batch_runner "$NODES" "$EDGES" "$NUMQ" "$SEED"
 python3 python/analyze_metrics.py results/metrics_batch.csv
+python3 python/analyze_metrics.py results/latency_histogram.csv
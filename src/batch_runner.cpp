@@ -3,89 +3,540 @@
 #include "graph.h"
 #include "planner.h"
 #include "io.h"
+#include "latency_histogram.h"
+#include "parallel.h"
+#include "result_cache.h"
+#include "synthetic.h"
+#include "graph_updates.h"
+#include "isochrone.h"
 #include <iostream>
 #include <random>
 #include <vector>
 #include <algorithm>
+#include <sstream>
 #include <fstream>
 #include <chrono>
 #include <numeric>
+#include <functional>
+#include <memory>
+#include <cmath>
+#include <atomic>
+#include <thread>
 
-static double percentile(std::vector<long long> &v, double p) {
-    if (v.empty()) return 0.0;
-    std::sort(v.begin(), v.end());
-    double idx = (p/100.0) * (v.size()-1);
-    size_t lo = (size_t)std::floor(idx), hi=(size_t)std::ceil(idx);
-    if (lo==hi) return (double)v[lo];
-    double frac = idx - lo;
-    return v[lo] * (1-frac) + v[hi]*frac;
+// per-algorithm results across the batch, indexed by query
+struct Series {
+    std::string label;
+    std::function<Stats(int,int,SearchContext&)> run;
+    double wall_ms = 0.0;
+    LatencyHistogram latency;   // per-query wall time in ns (search + path + cache lookup), merged over workers
+    std::vector<size_t> nodes;
+    std::vector<double> dist;
+    std::vector<size_t> pathlen;
+    std::vector<size_t> pushes;
+    std::vector<SearchCounters> counters;
+    CacheCounters cache;
+    size_t reference = 0;       // series whose distances this one must reproduce
+};
+
+// value of `--name value` anywhere in argv, or def
+static std::string flag_value(int argc, char** argv, const std::string &name, const std::string &def) {
+    for (int i = 1; i+1 < argc; ++i) if (argv[i] == name) return argv[i+1];
+    return def;
 }
 
 int main(int argc,char** argv) {
     std::cout<<"Batch runner: runs 100 queries (default). Usage:\n";
-    std::cout<<argv[0]<<" <cities.csv> <routes.csv> [num_queries] [seed]\n";
-    if (argc < 3) return 1;
-    std::string nodes_csv = argv[1], edges_csv = argv[2];
-    int numq = (argc>=4) ? std::stoi(argv[3]) : 100;
-    unsigned seed = (argc>=5) ? std::stoul(argv[4]) : (unsigned)std::chrono::system_clock::now().time_since_epoch().count();
+    std::cout<<argv[0]<<" <cities.csv> <routes.csv> | <graph.rpg> [num_queries] [seed] [--landmarks K] [--landmark-file path] [--threads N] [--queue binary|radix|dary] [--matrix K [--lanes 4|8|16]] [--reorder hilbert|bfs]\n"
+             <<"       [--sssp K [--delta D]] [--range B1,B2,... [--cell-km C]] [--geojson path [--simplify KM]]\n"
+             <<"       [--cache N] [--zipf S] [--pairs P] [--no-ch] [--metrics-json path] [--directed] [--metric NAME]\n"
+             <<"       [--profiles path|synthetic] [--depart seconds] [--updates path|synthetic] [--update-count N] [--update-batch N]\n"
+             <<argv[0]<<" --synthetic grid|geometric|road [--nodes N] [num_queries] [seed] [options]\n";
+    std::vector<std::string> pos;
+    bool with_ch = true, directed = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        // the only flags without a value
+        if (arg == "--no-ch") { with_ch = false; continue; }
+        if (arg == "--directed") { directed = true; continue; }
+        if (arg.rfind("--", 0) == 0) { ++i; continue; }
+        pos.push_back(arg);
+    }
+    // a binary snapshot replaces the cities.csv / routes.csv pair, a generated graph needs neither
+    std::string synthetic = flag_value(argc, argv, "--synthetic", "");
+    bool snapshot = synthetic.empty() && !pos.empty() && Graph::is_snapshot(pos[0]);
+    size_t a0 = !synthetic.empty() ? 0 : snapshot ? 1 : 2;
+    if (pos.size() < a0) return 1;
+    int numq = (pos.size()>=a0+1) ? std::stoi(pos[a0]) : 100;
+    unsigned seed = (pos.size()>=a0+2) ? std::stoul(pos[a0+1]) : (unsigned)std::chrono::system_clock::now().time_since_epoch().count();
+    int num_landmarks = std::stoi(flag_value(argc, argv, "--landmarks", "0"));
+    std::string landmark_file = flag_value(argc, argv, "--landmark-file", "");
+    int threads = std::stoi(flag_value(argc, argv, "--threads", std::to_string(default_threads())));
+    QueueKind queue = QueueKind::Binary;
+    std::string queue_name = flag_value(argc, argv, "--queue", "binary");
+    if (!parse_queue_kind(queue_name, queue)) { std::cerr << "Unknown queue: " << queue_name << "\n"; return 1; }
+    int matrix_size = std::stoi(flag_value(argc, argv, "--matrix", "0"));
+    size_t cache_size = std::stoul(flag_value(argc, argv, "--cache", "0"));
+    double zipf = std::stod(flag_value(argc, argv, "--zipf", "0"));
+    int num_pairs = std::max(1, std::stoi(flag_value(argc, argv, "--pairs", "1000")));
+    NodeOrder order = NodeOrder::Input;
+    std::string order_name = flag_value(argc, argv, "--reorder", "input");
+    if (!parse_node_order(order_name, order)) { std::cerr << "Unknown order: " << order_name << "\n"; return 1; }
 
     Graph g;
-    if (!g.load_nodes_csv(nodes_csv)) return 2;
-    if (!g.load_edges_csv(edges_csv)) return 3;
+    auto g0 = std::chrono::high_resolution_clock::now();
+    if (!synthetic.empty()) {
+        SyntheticOptions so;
+        if (!parse_synthetic_kind(synthetic, so.kind)) { std::cerr << "Unknown graph kind: " << synthetic << "\n"; return 1; }
+        so.nodes = std::stoi(flag_value(argc, argv, "--nodes", "100000"));
+        g = make_synthetic_graph(so);
+    } else if (snapshot) {
+        if (!g.load_snapshot(pos[0])) return 2;
+    } else {
+        if (!g.load_nodes_csv(pos[0])) return 2;
+        if (!g.load_edges_csv(pos[1], !directed)) return 3;
+    }
+    auto g1 = std::chrono::high_resolution_clock::now();
+    std::cout<<"Graph load: "<<std::chrono::duration<double, std::milli>(g1-g0).count()<<" ms ("
+             <<(!synthetic.empty() ? "synthetic " + synthetic : snapshot ? "snapshot" : "csv")<<"), nodes="<<g.num_nodes()<<" edges="<<g.num_edges()
+             <<(g.is_directed() ? " directed" : "")<<"\n";
+    // every search, the hierarchy and the landmarks use this edge metric
+    std::string metric_name = flag_value(argc, argv, "--metric", g.metric_name(0));
+    int metric = g.find_metric(metric_name);
+    if (metric < 0) {
+        std::cerr<<"Unknown metric: "<<metric_name<<" (have";
+        for (int k = 0; k < g.num_metrics(); ++k) std::cerr<<" "<<g.metric_name(k);
+        std::cerr<<")\n";
+        return 1;
+    }
+    if (g.num_metrics() > 1) std::cout<<"Metric: "<<g.metric_name(metric)<<" ("<<g.num_metrics()<<" available)\n";
+    if (order != NodeOrder::Input) {
+        auto r0 = std::chrono::high_resolution_clock::now();
+        g.reorder(order);
+        auto r1 = std::chrono::high_resolution_clock::now();
+        std::cout<<"Reorder ("<<node_order_name(order)<<"): "<<std::chrono::duration<double, std::milli>(r1-r0).count()<<" ms\n";
+    }
     int n = g.num_nodes();
     if (n<2) { std::cerr<<"Not enough nodes\n"; return 4; }
 
+    // time-dependent queries: profiles from a CSV (or generated), all leaving at --depart
+    std::string profiles_path = flag_value(argc, argv, "--profiles", "");
+    double depart = std::stod(flag_value(argc, argv, "--depart", "28800"));
+    TravelTimeProfiles profiles;
+    if (!profiles_path.empty()) {
+        auto p0 = std::chrono::high_resolution_clock::now();
+        bool ok = profiles_path == "synthetic" ? profiles.build(g, make_synthetic_profiles(g, seed), metric)
+                                               : profiles.load_csv(profiles_path, g, metric);
+        if (!ok) return 3;
+        auto p1 = std::chrono::high_resolution_clock::now();
+        std::cout<<"Profiles: "<<std::chrono::duration<double, std::milli>(p1-p0).count()<<" ms, edges="<<profiles.num_profiled_edges()
+                 <<" points="<<profiles.num_points()<<" bytes="<<profiles.bytes()<<" depart="<<depart<<"\n";
+    }
+
+    // SSSP mode: full trees from K random sources, Dijkstra vs delta-stepping on 1, 2, 4 .. --threads workers
+    int sssp_sources = std::stoi(flag_value(argc, argv, "--sssp", "0"));
+    if (sssp_sources > 0) {
+        double delta = std::stod(flag_value(argc, argv, "--delta", "0"));
+        std::mt19937 srng(seed);
+        std::uniform_int_distribution<int> sid(0,n-1);
+        std::vector<int> srcs(sssp_sources);
+        for (int &s : srcs) s = sid(srng);
+        std::vector<ShortestPathTree> refs;
+        SearchContext ctx;
+        ctx.metric = metric;
+        double dijkstra_ms = 0;
+        for (int s : srcs) {
+            refs.push_back(dijkstra_tree(g, s, ctx));
+            dijkstra_ms += refs.back().millis / 1000.0;
+        }
+        std::cout<<"SSSP_DIJKSTRA sources="<<sssp_sources<<" ms_per_tree="<<dijkstra_ms / sssp_sources<<"\n";
+        std::vector<int> counts;
+        for (int t = 1; t < threads; t *= 2) counts.push_back(t);
+        counts.push_back(std::max(1, threads));
+        for (int t : counts) {
+            ThreadPool pool(t);
+            double ms = 0;
+            size_t phases = 0, scans = 0, mismatches = 0;
+            ShortestPathTree tree;
+            for (size_t i = 0; i < srcs.size(); ++i) {
+                tree = delta_stepping(g, srcs[i], pool, delta, metric);
+                ms += tree.millis / 1000.0;
+                phases += tree.phases;
+                scans += tree.settled;
+                for (int v = 0; v < n; ++v) if (tree.dist[v] != refs[i].dist[v]) mismatches++;
+            }
+            std::cout<<"SSSP_DELTA threads="<<t<<" delta="<<tree.delta<<" ms_per_tree="<<ms / sssp_sources
+                     <<" speedup="<<(ms > 0 ? dijkstra_ms / ms : 0.0)<<" phases="<<phases / sssp_sources
+                     <<" scans_per_node="<<(double)scans / sssp_sources / n<<"\n";
+            if (mismatches) std::cerr<<"[CHECK] delta-stepping on "<<t<<" thread(s) differs from Dijkstra on "<<mismatches<<" nodes\n";
+        }
+        return 0;
+    }
+
+    // range mode: num_queries range searches per budget from random sources on one reused context,
+    // then the polygons of the first few
+    std::string budgets = flag_value(argc, argv, "--range", "");
+    if (!budgets.empty()) {
+        double cell_km = std::stod(flag_value(argc, argv, "--cell-km", "0"));
+        std::mt19937 rrng(seed);
+        std::uniform_int_distribution<int> rid(0,n-1);
+        std::vector<int> srcs(std::max(1, numq));
+        for (int &s : srcs) s = rid(rrng);
+        SearchContext ctx;
+        ctx.metric = metric;
+        ctx.queue = queue;
+        std::stringstream list(budgets);
+        for (std::string b; std::getline(list, b, ',');) {
+            const double budget = std::stod(b);
+            LatencyHistogram hist;
+            size_t reached = 0, frontier = 0;
+            for (int s : srcs) {
+                auto q0 = std::chrono::steady_clock::now();
+                RangeResult r = range_search(g, s, budget, ctx);
+                hist.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - q0).count());
+                reached += r.nodes.size();
+                frontier += r.frontier.size();
+            }
+            // polygons are drawn for a handful of sources; the search is what repeats
+            const size_t drawn = std::min<size_t>(srcs.size(), 10);
+            std::vector<RangeResult> outlined;
+            for (size_t i = 0; i < drawn; ++i) outlined.push_back(range_search(g, srcs[i], budget, ctx));
+            size_t polygons = 0, vertices = 0;
+            auto p0 = std::chrono::high_resolution_clock::now();
+            for (const RangeResult &r : outlined) {
+                for (const auto &poly : range_polygons(g, r, cell_km)) {
+                    polygons++;
+                    for (const auto &ring : poly) vertices += ring.size();
+                }
+            }
+            auto p1 = std::chrono::high_resolution_clock::now();
+            std::cout<<"RANGE budget="<<budget<<" queries="<<srcs.size()<<" mean_ms="<<hist.mean() / 1e6
+                     <<" p50_ms="<<hist.percentile(50) / 1e6<<" p99_ms="<<hist.percentile(99) / 1e6
+                     <<" nodes="<<reached / srcs.size()<<" frontier="<<frontier / srcs.size()
+                     <<" polygon_ms="<<std::chrono::duration<double, std::milli>(p1-p0).count() / drawn
+                     <<" polygons="<<(double)polygons / drawn<<" vertices="<<(double)vertices / drawn<<"\n";
+            // the range is exactly the nodes a full Dijkstra puts within the budget
+            ShortestPathTree tree = dijkstra_tree(g, srcs[0], metric);
+            size_t within = std::count_if(tree.dist.begin(), tree.dist.end(), [&](double d) { return d <= budget; });
+            if (within != range_search(g, srcs[0], budget, ctx).nodes.size())
+                std::cerr<<"[CHECK] range of "<<budget<<" differs from Dijkstra: "<<within<<" nodes within the budget\n";
+        }
+        return 0;
+    }
+
+    // CH preprocessing dominates startup on large graphs; --no-ch drops the ch algorithm (and the CH matrix)
+    ContractionHierarchy ch;
+    if (with_ch) {
+        auto c0 = std::chrono::high_resolution_clock::now();
+        ch.build(g, metric);
+        auto c1 = std::chrono::high_resolution_clock::now();
+        std::cout<<"CH preprocessing: "<<std::chrono::duration_cast<std::chrono::milliseconds>(c1-c0).count()
+                 <<" ms, shortcuts="<<ch.num_shortcuts()<<"\n";
+    }
+
+    // ALT: reuse persisted tables when they match the graph, else build (and persist)
+    Landmarks lm;
+    if (num_landmarks > 0 || !landmark_file.empty()) {
+        if (landmark_file.empty() || !lm.load(landmark_file, g, metric) || (num_landmarks > 0 && lm.count() != num_landmarks)) {
+            auto l0 = std::chrono::high_resolution_clock::now();
+            lm.build(g, num_landmarks > 0 ? num_landmarks : 16, LandmarkSelection::Avoid, 0, 1, metric);
+            auto l1 = std::chrono::high_resolution_clock::now();
+            std::cout<<"ALT preprocessing: "<<std::chrono::duration_cast<std::chrono::milliseconds>(l1-l0).count()
+                     <<" ms, landmarks="<<lm.count()<<"\n";
+            if (!landmark_file.empty() && lm.save(landmark_file)) std::cout<<"Saved landmarks to "<<landmark_file<<"\n";
+        } else {
+            std::cout<<"Loaded "<<lm.count()<<" landmarks from "<<landmark_file<<"\n";
+        }
+    }
+
+    // matrix mode: K x K distance matrix between K random nodes instead of pair queries
+    if (matrix_size > 0) {
+        std::mt19937 mrng(seed);
+        std::uniform_int_distribution<int> mid(0,n-1);
+        std::vector<int> pts(matrix_size), ext(matrix_size);
+        for (int i = 0; i < matrix_size; ++i) { ext[i] = mid(mrng); pts[i] = g.to_internal(ext[i]); }
+        std::cout<<"Distance matrix "<<matrix_size<<"x"<<matrix_size<<" on "<<threads<<" thread(s)\n";
+        DistanceMatrix md = many_to_many(g, pts, pts, threads, metric);
+        std::cout<<"MATRIX_DIJKSTRA wall_ms="<<md.millis/1000.0<<" nodes="<<md.nodes_expanded
+                 <<" cells_per_sec="<<(md.millis > 0 ? md.dist.size() / (md.millis/1e6) : 0.0)<<"\n";
+        // the same rows as multi-source searches, --lanes sources at a time
+        int lanes = std::stoi(flag_value(argc, argv, "--lanes", "8"));
+        DistanceMatrix ml = many_to_many_lanes(g, pts, pts, threads, metric, lanes);
+        std::cout<<"MATRIX_LANES lanes="<<lanes<<" wall_ms="<<ml.millis/1000.0<<" scans="<<ml.nodes_expanded
+                 <<" cells_per_sec="<<(ml.millis > 0 ? ml.dist.size() / (ml.millis/1e6) : 0.0)<<"\n";
+        size_t lane_mismatches = 0;
+        for (size_t k = 0; k < md.dist.size(); ++k)
+            if (!(md.dist[k] == ml.dist[k]) && !(std::fabs(md.dist[k] - ml.dist[k]) < 1e-9 * std::max(1.0, md.dist[k]))) lane_mismatches++;
+        if (lane_mismatches) std::cerr<<"[CHECK] lanes matrix differs from Dijkstra in "<<lane_mismatches<<" cells\n";
+        DistanceMatrix mc = md;
+        if (with_ch) {
+            mc = many_to_many(ch, pts, pts, threads);
+            std::cout<<"MATRIX_CH wall_ms="<<mc.millis/1000.0<<" nodes="<<mc.nodes_expanded
+                     <<" cells_per_sec="<<(mc.millis > 0 ? mc.dist.size() / (mc.millis/1e6) : 0.0)<<"\n";
+            size_t mismatches = 0;
+            for (size_t k = 0; k < md.dist.size(); ++k) {
+                bool both_inf = std::isinf(md.dist[k]) && std::isinf(mc.dist[k]);
+                if (!both_inf && !(std::fabs(md.dist[k] - mc.dist[k]) < 1e-6)) mismatches++;
+            }
+            if (mismatches) std::cerr<<"[CHECK] CH matrix differs from Dijkstra in "<<mismatches<<" cells\n";
+        }
+        mc.sources = ext; mc.targets = ext;
+        if (!write_matrix_csv("results/matrix.csv", mc)) return 5;
+        std::cout<<"Wrote results/matrix.csv\n";
+        return 0;
+    }
+
+    std::vector<Series> algos;
+    algos.push_back({"dijkstra", [&](int s,int t,SearchContext &ctx){ return dijkstra_search(g,s,t,ctx); }});
+    algos.push_back({"astar", [&](int s,int t,SearchContext &ctx){ return astar_search(g,s,t,ctx); }});
+    algos.push_back({"bidir_dijkstra", [&](int s,int t,SearchContext &ctx){ return bidir_dijkstra_search(g,s,t,ctx); }});
+    algos.push_back({"bidir_astar", [&](int s,int t,SearchContext &ctx){ return bidir_astar_search(g,s,t,ctx); }});
+    if (with_ch) algos.push_back({"ch", [&](int s,int t,SearchContext &ctx){ return ch_search(ch,s,t,ctx); }});
+    if (!lm.empty()) {
+        algos.push_back({"astar_alt", [&](int s,int t,SearchContext &ctx){ return astar_search(g,s,t,ctx,&lm); }});
+        algos.push_back({"bidir_astar_alt", [&](int s,int t,SearchContext &ctx){ return bidir_astar_search(g,s,t,ctx,&lm); }});
+    }
+
+    if (!profiles_path.empty()) {
+        // time-dependent costs differ from the static ones: the A* variant is checked against td_dijkstra
+        size_t td = algos.size();
+        algos.push_back({"td_dijkstra", [&](int s,int t,SearchContext &ctx){ return td_dijkstra_search(g,profiles,s,t,depart,ctx); }});
+        algos.back().reference = td;
+        algos.push_back({"td_astar", [&](int s,int t,SearchContext &ctx){ return td_astar_search(g,profiles,s,t,depart,ctx); }});
+        algos.back().reference = td;
+    }
+
+    // generate all pairs up front so results do not depend on thread scheduling;
+    // pairs are drawn as input ids so a reordered graph answers the same queries
     std::mt19937 rng(seed);
     std::uniform_int_distribution<int> uid(0,n-1);
+    std::vector<std::pair<int,int>> queries;
+    auto random_pair = [&]() {
+        int s, t;
+        do { s = uid(rng); t = uid(rng); } while (s == t);
+        return std::make_pair(g.to_internal(s), g.to_internal(t));
+    };
+    if (zipf > 0) {
+        // skewed traffic: the k-th of num_pairs fixed pairs is drawn with probability ~ 1/k^zipf
+        std::vector<std::pair<int,int>> pool_pairs(num_pairs);
+        for (auto &p : pool_pairs) p = random_pair();
+        std::vector<double> weights(num_pairs);
+        for (int k = 0; k < num_pairs; ++k) weights[k] = 1.0 / std::pow(k + 1.0, zipf);
+        std::discrete_distribution<int> rank(weights.begin(), weights.end());
+        while ((int)queries.size() < numq) queries.push_back(pool_pairs[rank(rng)]);
+        std::cout<<"Zipf queries: s="<<zipf<<" over "<<num_pairs<<" pairs\n";
+    } else {
+        while ((int)queries.size() < numq) queries.push_back(random_pair());
+    }
+    std::unique_ptr<ResultCache> cache;
+    if (cache_size > 0) cache = std::make_unique<ResultCache>(cache_size);
 
-    std::vector<long long> dij_times, astar_times, bidir_times;
-    std::vector<size_t> dij_nodes, astar_nodes, bidir_nodes;
-    std::vector<double> dij_dist, astar_dist, bidir_dist;
-    std::vector<size_t> dij_pathlen, astar_pathlen, bidir_pathlen;
-
-    for (int i=0;i<numq;i++){
-        int s = uid(rng), t = uid(rng);
-        if (s==t) { i--; continue; }
-        Stats sd = dijkstra_search(g,s,t);
-        Stats sa = astar_search(g,s,t);
-        Stats sb = bidir_astar_search(g,s,t);
-
-    dij_times.push_back(sd.millis); dij_nodes.push_back(sd.nodes_expanded); dij_dist.push_back(sd.distance); dij_pathlen.push_back(sd.path.size());
-    astar_times.push_back(sa.millis); astar_nodes.push_back(sa.nodes_expanded); astar_dist.push_back(sa.distance); astar_pathlen.push_back(sa.path.size());
-    bidir_times.push_back(sb.millis); bidir_nodes.push_back(sb.nodes_expanded); bidir_dist.push_back(sb.distance); bidir_pathlen.push_back(sb.path.size());
-
-        if (!std::isfinite(sb.distance)) {
-            std::cerr << "[DEBUG] Bidirectional A* failed for query " << i
-                      << ": src=" << s << " (" << g.get_names()[s] << ")"
-                      << ", tgt=" << t << " (" << g.get_names()[t] << ")"
-                      << ". Dijkstra distance=" << sd.distance << ", A* distance=" << sa.distance << "\n";
-        }
+    // workers share the read-only graph; each owns a search context and writes only its queries' slots
+    ThreadPool pool(threads);
+    std::vector<SearchContext> contexts(pool.size());
+    for (auto &c : contexts) { c.queue = queue; c.metric = metric; }
+    // the first series' routes stream into one FeatureCollection as the workers finish them
+    std::string geojson_path = flag_value(argc, argv, "--geojson", "");
+    std::unique_ptr<GeoJsonRouteStream> routes;
+    std::vector<long long> worker_write_ns(pool.size(), 0);
+    if (!geojson_path.empty()) {
+        routes = std::make_unique<GeoJsonRouteStream>(geojson_path, std::stod(flag_value(argc, argv, "--simplify", "0")));
+        if (!routes->is_open()) return 5;
+    }
+    std::cout<<"Running "<<numq<<" queries on "<<pool.size()<<" thread(s), "<<queue_kind_name(queue)<<" queue\n";
+    for (size_t k = 0; k < algos.size(); ++k) {
+        Series &a = algos[k];
+        a.nodes.assign(numq, 0); a.dist.assign(numq, 0.0); a.pathlen.assign(numq, 0);
+        a.pushes.assign(numq, 0); a.counters.assign(numq, SearchCounters());
+        // every algorithm starts from an empty cache
+        if (cache) cache->clear();
+        // one histogram per worker, merged afterwards: recording needs no synchronisation
+        std::vector<LatencyHistogram> worker_latency(pool.size());
+        auto w0 = std::chrono::high_resolution_clock::now();
+        pool.for_each(numq, 16, [&](int i, int worker) {
+            int s = queries[i].first, t = queries[i].second;
+            auto q0 = std::chrono::steady_clock::now();
+            Stats st = cached_query(cache.get(), CacheKey{s, t, (int)k, g.version()},
+                                    [&]() { return a.run(s, t, contexts[worker]); });
+            auto q1 = std::chrono::steady_clock::now();
+            worker_latency[worker].record(std::chrono::duration_cast<std::chrono::nanoseconds>(q1 - q0).count());
+            a.nodes[i] = st.nodes_expanded; a.dist[i] = st.distance; a.pathlen[i] = st.path.size();
+            a.pushes[i] = st.pq_pushes; a.counters[i] = st.counters;
+            if (routes && k == 0) {
+                routes->add(g, st.path, a.label, st.distance);
+                worker_write_ns[worker] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - q1).count();
+            }
+        });
+        auto w1 = std::chrono::high_resolution_clock::now();
+        a.wall_ms = std::chrono::duration<double, std::milli>(w1 - w0).count();
+        a.latency.clear();
+        for (const auto &h : worker_latency) a.latency.merge(h);
+        if (cache) a.cache = cache->counters();
+        std::cout<<"Completed "<<a.label<<" "<<numq<<"/"<<numq<<"\n";
+    }
+
+    if (routes) {
+        auto c0 = std::chrono::steady_clock::now();
+        bool ok = routes->close();
+        long long write_ns = std::accumulate(worker_write_ns.begin(), worker_write_ns.end(), 0LL)
+                           + std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - c0).count();
+        std::cout<<"GEOJSON "<<algos[0].label<<" routes="<<routes->features()<<" vertices="<<routes->vertices()
+                 <<" path_nodes="<<routes->path_nodes()<<" bytes="<<routes->bytes()<<" write_ms="<<write_ns / 1e6
+                 <<" MB/s="<<(write_ns > 0 ? routes->bytes() / (write_ns / 1e9) / 1e6 : 0.0)<<"\n";
+        if (ok) std::cout<<"Wrote "<<geojson_path<<"\n";
+    }
 
-        if ((i+1)%10==0) std::cout<<"Completed "<<(i+1)<<"/"<<numq<<"\n";
+    // every algorithm should agree with its reference (Dijkstra); report the queries where it does not
+    for (size_t k = 1; k < algos.size(); ++k) {
+        const Series &dij = algos[algos[k].reference];
+        if (&dij == &algos[k]) continue;
+        int mismatches = 0, first = -1;
+        for (int i = 0; i < numq; ++i) {
+            double a = algos[k].dist[i], d = dij.dist[i];
+            bool same = std::isinf(a) && std::isinf(d) ? true : std::fabs(a - d) <= 1e-9 * std::max(1.0, d);
+            if (!same && mismatches++ == 0) first = i;
+        }
+        if (!mismatches) continue;
+        int s = queries[first].first, t = queries[first].second;
+        std::cerr << "[CHECK] " << algos[k].label << " differs from " << dij.label << " on " << mismatches << "/" << numq
+                  << " queries, first: src=" << g.to_external(s) << " (" << g.get_names()[s] << ")"
+                  << ", tgt=" << g.to_external(t) << " (" << g.get_names()[t] << ")"
+                  << " dist=" << algos[k].dist[first] << " " << dij.label << "=" << dij.dist[first] << "\n";
     }
 
-    auto dump_stats = [&](const std::string &label, std::vector<long long> &times, std::vector<size_t> &nodes, std::vector<double> &dist){
-        double mean_time = std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+    auto dump_stats = [&](const std::string &label, const LatencyHistogram &lat, std::vector<size_t> &nodes, std::vector<double> &dist){
         double mean_nodes = std::accumulate(nodes.begin(), nodes.end(), 0.0) / nodes.size();
         double mean_dist = std::accumulate(dist.begin(), dist.end(), 0.0) / dist.size();
-        std::cout<<label<<" mean_time_ms="<<mean_time<<" mean_nodes="<<mean_nodes<<" mean_dist="<<mean_dist<<"\n";
-        std::cout<<label<<" p50_time="<<percentile(times,50)<<" p90_time="<<percentile(times,90)<<" p99_time="<<percentile(times,99)<<"\n";
+        std::cout<<label<<" mean_time_us="<<lat.mean()/1000.0<<" mean_nodes="<<mean_nodes<<" mean_dist="<<mean_dist<<"\n";
+        std::cout<<label<<" latency_ns p50="<<lat.percentile(50)<<" p90="<<lat.percentile(90)<<" p99="<<lat.percentile(99)
+                 <<" p99.9="<<lat.percentile(99.9)<<" max="<<lat.max()<<"\n";
     };
 
-    dump_stats("DIJKSTRA", dij_times, dij_nodes, dij_dist);
-    dump_stats("ASTAR", astar_times, astar_nodes, astar_dist);
-    dump_stats("BIDIR_ASTAR", bidir_times, bidir_nodes, bidir_dist);
-
-    // store metrics CSV
+    // store metrics CSV: one average row per algorithm
     std::vector<std::pair<std::string, Stats>> rows;
-    // average rows
-    Stats sdavg; sdavg.distance = std::accumulate(dij_dist.begin(), dij_dist.end(), 0.0)/dij_dist.size(); sdavg.nodes_expanded = (size_t)(std::accumulate(dij_nodes.begin(), dij_nodes.end(), 0.0)/dij_nodes.size()); sdavg.millis = (long long)(std::accumulate(dij_times.begin(), dij_times.end(), 0.0)/dij_times.size()); sdavg.path = std::vector<int>(std::max((size_t)1, (size_t)(std::accumulate(dij_pathlen.begin(), dij_pathlen.end(), 0.0)/dij_pathlen.size())), -1);
-    Stats saavg; saavg.distance = std::accumulate(astar_dist.begin(), astar_dist.end(), 0.0)/astar_dist.size(); saavg.nodes_expanded = (size_t)(std::accumulate(astar_nodes.begin(), astar_nodes.end(), 0.0)/astar_nodes.size()); saavg.millis = (long long)(std::accumulate(astar_times.begin(), astar_times.end(), 0.0)/astar_times.size()); saavg.path = std::vector<int>(std::max((size_t)1, (size_t)(std::accumulate(astar_pathlen.begin(), astar_pathlen.end(), 0.0)/astar_pathlen.size())), -1);
-    Stats sbavg; sbavg.distance = std::accumulate(bidir_dist.begin(), bidir_dist.end(), 0.0)/bidir_dist.size(); sbavg.nodes_expanded = (size_t)(std::accumulate(bidir_nodes.begin(), bidir_nodes.end(), 0.0)/bidir_nodes.size()); sbavg.millis = (long long)(std::accumulate(bidir_times.begin(), bidir_times.end(), 0.0)/bidir_times.size()); sbavg.path = std::vector<int>(std::max((size_t)1, (size_t)(std::accumulate(bidir_pathlen.begin(), bidir_pathlen.end(), 0.0)/bidir_pathlen.size())), -1);
-    rows.push_back({"dijkstra_avg", sdavg});
-    rows.push_back({"astar_avg", saavg});
-    rows.push_back({"bidir_astar_avg", sbavg});
+    for (auto &a : algos) {
+        std::string upper = a.label;
+        std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+        dump_stats(upper, a.latency, a.nodes, a.dist);
+        std::cout<<upper<<" throughput_qps="<<(a.wall_ms > 0 ? numq / (a.wall_ms/1000.0) : 0.0)<<" wall_ms="<<a.wall_ms<<"\n";
+        if (cache) std::cout<<upper<<" cache_hits="<<a.cache.hits<<" cache_misses="<<a.cache.misses
+                            <<" cache_evictions="<<a.cache.evictions<<" cache_hit_rate="<<a.cache.hit_rate()<<"\n";
+        Stats avg;
+        avg.distance = std::accumulate(a.dist.begin(), a.dist.end(), 0.0)/a.dist.size();
+        avg.nodes_expanded = (size_t)(std::accumulate(a.nodes.begin(), a.nodes.end(), 0.0)/a.nodes.size());
+        avg.millis = (long long)(a.latency.mean() / 1000.0);
+        avg.path = std::vector<int>(std::max((size_t)1, (size_t)(std::accumulate(a.pathlen.begin(), a.pathlen.end(), 0.0)/a.pathlen.size())), -1);
+        avg.pq_pushes = (size_t)(std::accumulate(a.pushes.begin(), a.pushes.end(), 0.0)/a.pushes.size());
+        // counters: per-query mean (integer division, like the other averaged columns)
+        SearchCounters sum;
+        for (const auto &c : a.counters) sum += c;
+        const int q = std::max(1, numq);
+        avg.counters.relaxations = sum.relaxations / q;
+        avg.counters.improvements = sum.improvements / q;
+        avg.counters.stale_pops = sum.stale_pops / q;
+        avg.counters.heuristic_evals = sum.heuristic_evals / q;
+        avg.counters.setup_ns = sum.setup_ns / q;
+        avg.counters.search_ns = sum.search_ns / q;
+        avg.counters.path_ns = sum.path_ns / q;
+        if (instrumentation_enabled)
+            std::cout<<upper<<" relaxations="<<avg.counters.relaxations<<" stale_pops="<<avg.counters.stale_pops
+                     <<" heuristic_evals="<<avg.counters.heuristic_evals<<" setup_ns="<<avg.counters.setup_ns
+                     <<" search_ns="<<avg.counters.search_ns<<" path_ns="<<avg.counters.path_ns<<"\n";
+        rows.push_back({a.label + "_avg", avg});
+    }
     write_metrics_csv("results/metrics_batch.csv", rows);
     std::cout<<"Wrote results/metrics_batch.csv\n";
+
+    /* Update mode: the batches of --updates applied to a copy of the graph in
+       place (which a server could only do while not answering), then as
+       copy-on-write versions by a writer thread while the pool keeps running
+       bidir_astar queries on whatever version is current. */
+    LatencyHistogram publish_latency, update_query_latency;
+    std::string updates_path = flag_value(argc, argv, "--updates", "");
+    if (!updates_path.empty()) {
+        std::vector<std::vector<EdgeUpdate>> batches;
+        if (updates_path == "synthetic") {
+            size_t count = std::stoul(flag_value(argc, argv, "--update-count", "10000"));
+            size_t batch = std::max(1ul, std::stoul(flag_value(argc, argv, "--update-batch", "1000")));
+            std::vector<EdgeUpdate> all = make_synthetic_updates(g, count, seed);
+            for (size_t a = 0; a < all.size(); a += batch)
+                batches.emplace_back(all.begin() + a, all.begin() + std::min(all.size(), a + batch));
+        } else if (!load_update_stream(updates_path, g, batches)) {
+            return 6;
+        }
+        size_t total = 0;
+        for (const auto &b : batches) total += b.size();
+
+        Graph inplace(g);
+        UpdateResult sum;
+        auto u0 = std::chrono::high_resolution_clock::now();
+        for (const auto &b : batches) {
+            UpdateResult r = inplace.apply_updates(b, metric);
+            sum.applied += r.applied; sum.missing += r.missing; sum.edges_changed += r.edges_changed;
+        }
+        auto u1 = std::chrono::high_resolution_clock::now();
+        double inplace_ms = std::chrono::duration<double, std::milli>(u1 - u0).count();
+        std::cout<<"UPDATES batches="<<batches.size()<<" updates="<<total<<" applied="<<sum.applied<<" missing="<<sum.missing
+                 <<" edges_changed="<<sum.edges_changed<<"\n";
+        std::cout<<"UPDATES_INPLACE total_ms="<<inplace_ms<<" per_batch_ms="<<inplace_ms / std::max((size_t)1, batches.size())
+                 <<" updates_per_sec="<<(inplace_ms > 0 ? total / (inplace_ms/1000.0) : 0.0)<<"\n";
+
+        GraphVersions versions{Graph(g)};
+        std::atomic<bool> writing{true};
+        double copy_ms = 0, apply_ms = 0;
+        std::thread writer([&]() {
+            for (const auto &b : batches) {
+                auto p0 = std::chrono::steady_clock::now();
+                GraphVersions::Published p = versions.apply(b, metric);
+                auto p1 = std::chrono::steady_clock::now();
+                publish_latency.record(std::chrono::duration_cast<std::chrono::nanoseconds>(p1 - p0).count());
+                copy_ms += p.copy_ms;
+                apply_ms += p.apply_ms;
+            }
+            writing = false;
+        });
+        std::vector<LatencyHistogram> worker_latency(pool.size());
+        auto w0 = std::chrono::high_resolution_clock::now();
+        while (writing) {
+            pool.for_each(numq, 16, [&](int i, int worker) {
+                if (!writing) return;
+                auto cur = versions.current();
+                auto q0 = std::chrono::steady_clock::now();
+                bidir_astar_search(*cur, queries[i].first, queries[i].second, contexts[worker]);
+                auto q1 = std::chrono::steady_clock::now();
+                worker_latency[worker].record(std::chrono::duration_cast<std::chrono::nanoseconds>(q1 - q0).count());
+            });
+        }
+        writer.join();
+        auto w1 = std::chrono::high_resolution_clock::now();
+        for (const auto &h : worker_latency) update_query_latency.merge(h);
+        double cow_ms = std::chrono::duration<double, std::milli>(w1 - w0).count();
+        const double nb = (double)std::max((size_t)1, batches.size());
+        std::cout<<"UPDATES_COW total_ms="<<cow_ms<<" copy_ms="<<copy_ms / nb<<" apply_ms="<<apply_ms / nb
+                 <<" publish_latency_ns p50="<<publish_latency.percentile(50)<<" p99="<<publish_latency.percentile(99)
+                 <<" max="<<publish_latency.max()<<"\n";
+        std::cout<<"UPDATES_QUERIES bidir_astar queries="<<update_query_latency.count()
+                 <<" latency_ns p50="<<update_query_latency.percentile(50)<<" p90="<<update_query_latency.percentile(90)
+                 <<" p99="<<update_query_latency.percentile(99)<<" max="<<update_query_latency.max()<<"\n";
+
+        // the last version must answer like the graph updated in place
+        auto last = versions.current();
+        int mismatches = 0;
+        for (int i = 0; i < std::min(numq, 100); ++i) {
+            double a = dijkstra_search(*last, queries[i].first, queries[i].second, contexts[0]).distance;
+            double b = dijkstra_search(inplace, queries[i].first, queries[i].second, contexts[0]).distance;
+            if (!(std::isinf(a) && std::isinf(b)) && !(std::fabs(a - b) <= 1e-9 * std::max(1.0, b))) mismatches++;
+        }
+        if (mismatches) std::cerr<<"[CHECK] copy-on-write version differs from in-place updates on "<<mismatches<<" queries\n";
+    }
+
+    std::vector<std::pair<std::string, const LatencyHistogram*>> hists;
+    for (const auto &a : algos) hists.push_back({a.label, &a.latency});
+    if (publish_latency.count()) {
+        hists.push_back({"update_publish", &publish_latency});
+        hists.push_back({"bidir_astar_during_updates", &update_query_latency});
+    }
+    if (write_histograms_csv("results/latency_histogram.csv", hists)) std::cout<<"Wrote results/latency_histogram.csv\n";
+    std::string metrics_json = flag_value(argc, argv, "--metrics-json", "");
+    if (!metrics_json.empty() && write_metrics_json(metrics_json, rows)) std::cout<<"Wrote "<<metrics_json<<"\n";
     return 0;
 }
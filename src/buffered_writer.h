@@ -0,0 +1,114 @@
+#ifndef BUFFERED_WRITER_H
+#define BUFFERED_WRITER_H
+
+#include <charconv>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+/* Text output for large exports. Tokens are appended to a buffer that
+   goes to the file with one fwrite per ~64 KiB, and numbers are formatted
+   with std::to_chars, so a token costs neither a streambuf call nor a
+   locale lookup. Doubles print exactly like an ostream in the same mode:
+   general(p) (the default, p = 6) like "%.*g", fixed(p) like "%.*f".
+   Without open() the writer only collects text (view() / str()), e.g. to
+   format a record on one thread and append it to a shared writer later.
+   Write errors are sticky and reported by close().
+*/
+class BufferedWriter {
+public:
+    static constexpr size_t FLUSH_BYTES = 1 << 16;
+
+    BufferedWriter() = default;
+    explicit BufferedWriter(const std::string &path) { open(path); }
+    ~BufferedWriter() { close(); }
+    BufferedWriter(const BufferedWriter&) = delete;
+    BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+    bool open(const std::string &path) {
+        close();
+        file = std::fopen(path.c_str(), "wb");
+        failed = file == nullptr;
+        buf.reserve(FLUSH_BYTES + 512);
+        written = 0;
+        return file != nullptr;
+    }
+    bool is_open() const { return file != nullptr; }
+    // flushes and closes the file; false when any write failed
+    bool close() {
+        if (!file) return !failed;
+        flush();
+        failed |= std::fclose(file) != 0;
+        file = nullptr;
+        return !failed;
+    }
+    bool flush() {
+        if (file && !buf.empty()) {
+            failed |= std::fwrite(buf.data(), 1, buf.size(), file) != buf.size();
+            written += buf.size();
+            buf.clear();
+        }
+        return !failed;
+    }
+
+    BufferedWriter& fixed(int p) { fmt = std::chars_format::fixed; precision = p; return *this; }
+    BufferedWriter& general(int p) { fmt = std::chars_format::general; precision = p; return *this; }
+
+    BufferedWriter& operator<<(std::string_view s) {
+        buf.insert(buf.end(), s.begin(), s.end());
+        return spill();
+    }
+    BufferedWriter& operator<<(const char *s) { return *this << std::string_view(s); }
+    BufferedWriter& operator<<(const std::string &s) { return *this << std::string_view(s); }
+    BufferedWriter& operator<<(char c) {
+        buf.push_back(c);
+        return spill();
+    }
+    BufferedWriter& operator<<(double v) {
+        char tmp[352];  // fixed notation of DBL_MAX plus the precision
+        auto r = std::to_chars(tmp, tmp + sizeof(tmp), v, fmt, precision);
+        if (r.ec != std::errc()) {  // only with absurd precisions
+            int len = std::snprintf(nullptr, 0, fmt == std::chars_format::fixed ? "%.*f" : "%.*g", precision, v);
+            size_t at = buf.size();
+            buf.resize(at + len + 1);
+            std::snprintf(buf.data() + at, len + 1, fmt == std::chars_format::fixed ? "%.*f" : "%.*g", precision, v);
+            buf.pop_back();
+            return spill();
+        }
+        buf.insert(buf.end(), tmp, r.ptr);
+        return spill();
+    }
+    BufferedWriter& operator<<(float v) { return *this << (double)v; }
+    // integers wider than a char (chars print as characters, as on a stream)
+    template <typename T, typename = std::enable_if_t<std::is_integral<T>::value && (sizeof(T) > 1)>>
+    BufferedWriter& operator<<(T v) {
+        char tmp[24];
+        auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        buf.insert(buf.end(), tmp, r.ptr);
+        return spill();
+    }
+
+    // text not yet flushed (everything, for a writer without a file)
+    std::string_view view() const { return {buf.data(), buf.size()}; }
+    std::string str() const { return {buf.data(), buf.size()}; }
+    void clear() { buf.clear(); }
+    // bytes handed to the file so far plus the ones still buffered
+    size_t bytes() const { return written + buf.size(); }
+
+private:
+    std::FILE *file = nullptr;
+    std::vector<char> buf;
+    std::chars_format fmt = std::chars_format::general;
+    int precision = 6;
+    bool failed = false;
+    size_t written = 0;
+
+    BufferedWriter& spill() {
+        if (file && buf.size() >= FLUSH_BYTES) flush();
+        return *this;
+    }
+};
+
+#endif // BUFFERED_WRITER_H
@@ -0,0 +1,162 @@
+#include "ch.h"
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include <functional>
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+// witness searches give up after settling this many nodes; giving up only
+// adds a (possibly unnecessary) shortcut, never a wrong distance
+const int WITNESS_SETTLE_LIMIT = 500;
+
+// mutable adjacency used while contracting; holds only uncontracted nodes
+struct DynGraph {
+    std::vector<std::vector<CHEdge>> out, in;
+
+    explicit DynGraph(int n): out(n), in(n) {}
+
+    // insert u->v or lower its weight if it already exists
+    void add(int u, int v, double w, int mid) {
+        for (auto &e : out[u]) {
+            if (e.to != v) continue;
+            if (w < e.w) {
+                e.w = w; e.mid = mid;
+                for (auto &r : in[v]) if (r.to == u) { r.w = w; r.mid = mid; break; }
+            }
+            return;
+        }
+        out[u].push_back({v, w, mid});
+        in[v].push_back({u, w, mid});
+    }
+};
+
+// bounded Dijkstra that avoids one node; dist is reset through the touched list
+struct WitnessSearch {
+    std::vector<double> dist;
+    std::vector<int> touched;
+
+    explicit WitnessSearch(int n): dist(n, INF) {}
+
+    void run(const DynGraph &dg, int s, int skip, double max_dist) {
+        for (int v : touched) dist[v] = INF;
+        touched.clear();
+        using PQ = std::pair<double,int>;
+        std::priority_queue<PQ, std::vector<PQ>, std::greater<PQ>> pq;
+        dist[s] = 0.0; touched.push_back(s);
+        pq.push({0.0, s});
+        int settled = 0;
+        while (!pq.empty()) {
+            auto [d,u] = pq.top(); pq.pop();
+            if (d != dist[u]) continue;
+            if (d > max_dist || ++settled > WITNESS_SETTLE_LIMIT) break;
+            for (const auto &e : dg.out[u]) {
+                if (e.to == skip) continue;
+                double nd = d + e.w;
+                if (nd < dist[e.to]) {
+                    if (dist[e.to] == INF) touched.push_back(e.to);
+                    dist[e.to] = nd;
+                    pq.push({nd, e.to});
+                }
+            }
+        }
+    }
+};
+
+struct Shortcut { int u, v; double w; };
+
+// shortcuts needed to contract v (every in/out pair without a witness)
+void find_shortcuts(const DynGraph &dg, WitnessSearch &ws, int v, std::vector<Shortcut> &res) {
+    res.clear();
+    double max_out = 0.0;
+    for (const auto &e : dg.out[v]) max_out = std::max(max_out, e.w);
+    for (const auto &in : dg.in[v]) {
+        int u = in.to;
+        ws.run(dg, u, v, in.w + max_out);
+        for (const auto &out : dg.out[v]) {
+            int w = out.to;
+            if (w == u) continue;
+            double via = in.w + out.w;
+            if (ws.dist[w] > via) res.push_back({u, w, via});
+        }
+    }
+}
+
+void to_csr(const std::vector<std::vector<CHEdge>> &lists, std::vector<int> &offsets, std::vector<CHEdge> &edges) {
+    offsets.assign(lists.size()+1, 0);
+    for (size_t u = 0; u < lists.size(); ++u) offsets[u+1] = offsets[u] + (int)lists[u].size();
+    edges.clear();
+    edges.reserve(offsets.back());
+    for (const auto &l : lists) edges.insert(edges.end(), l.begin(), l.end());
+}
+
+} // namespace
+
+void ContractionHierarchy::build(const Graph &g, int metric) {
+    const int n = g.num_nodes();
+    metric_ = metric;
+    DynGraph dg(n);
+    for (int u = 0; u < n; ++u)
+        for (const auto &e : g.neighbors(u, metric))
+            if (e.to != u) dg.add(u, e.to, e.w, -1);
+
+    WitnessSearch ws(n);
+    std::vector<Shortcut> sc;
+    std::vector<int> deleted_neighbors(n, 0);
+    std::vector<char> contracted(n, 0);
+    auto priority = [&](int v) {
+        find_shortcuts(dg, ws, v, sc);
+        return (int)sc.size() - (int)(dg.in[v].size() + dg.out[v].size()) + deleted_neighbors[v];
+    };
+
+    using PQ = std::pair<int,int>;
+    std::priority_queue<PQ, std::vector<PQ>, std::greater<PQ>> pq;
+    for (int v = 0; v < n; ++v) pq.push({priority(v), v});
+
+    rank.assign(n, -1);
+    shortcuts = 0;
+    std::vector<std::vector<CHEdge>> up_out(n), up_in(n);
+    int order = 0;
+    while (!pq.empty()) {
+        int v = pq.top().second; pq.pop();
+        if (contracted[v]) continue;
+        // lazy update: re-queue if v is no longer the least important node
+        int p = priority(v);
+        if (!pq.empty() && p > pq.top().first) { pq.push({p, v}); continue; }
+
+        // sc holds v's shortcuts from the priority() call above
+        for (const auto &s : sc) { dg.add(s.u, s.v, s.w, v); ++shortcuts; }
+        up_out[v] = dg.out[v];
+        up_in[v] = dg.in[v];
+        for (const auto &e : dg.out[v]) {
+            auto &l = dg.in[e.to];
+            l.erase(std::remove_if(l.begin(), l.end(), [v](const CHEdge &x){ return x.to == v; }), l.end());
+            deleted_neighbors[e.to]++;
+        }
+        for (const auto &e : dg.in[v]) {
+            auto &l = dg.out[e.to];
+            l.erase(std::remove_if(l.begin(), l.end(), [v](const CHEdge &x){ return x.to == v; }), l.end());
+            deleted_neighbors[e.to]++;
+        }
+        dg.out[v].clear(); dg.out[v].shrink_to_fit();
+        dg.in[v].clear(); dg.in[v].shrink_to_fit();
+        contracted[v] = 1;
+        rank[v] = order++;
+    }
+    to_csr(up_out, out_offsets, out_edges);
+    to_csr(up_in, in_offsets, in_edges);
+}
+
+void ContractionHierarchy::unpack_edge(int u, int v, int mid, std::vector<int> &path) const {
+    if (mid < 0) { path.push_back(v); return; }
+    // u->mid is stored as an incoming upward edge of mid, mid->v as an outgoing one
+    const CHEdge *first = nullptr, *second = nullptr;
+    for (const CHEdge *e = up_in_begin(mid); e != up_in_end(mid); ++e)
+        if (e->to == u && (!first || e->w < first->w)) first = e;
+    for (const CHEdge *e = up_out_begin(mid); e != up_out_end(mid); ++e)
+        if (e->to == v && (!second || e->w < second->w)) second = e;
+    if (!first || !second) return; // corrupted hierarchy; leave the path short
+    unpack_edge(u, mid, first->mid, path);
+    unpack_edge(mid, v, second->mid, path);
+}
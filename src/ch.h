@@ -0,0 +1,51 @@
+#ifndef CH_H
+#define CH_H
+
+#include "graph.h"
+#include <vector>
+#include <cstddef>
+
+// edge of the contracted graph; mid is the bypassed node for shortcuts, -1 for original edges
+struct CHEdge {
+    int to;
+    double w;
+    int mid;
+};
+
+/* Contraction Hierarchy built offline from a Graph.
+   Nodes are contracted one by one in order of importance (edge difference +
+   contracted neighbours, lazily updated); a shortcut u->w via v is added
+   only when a bounded witness search finds no path u->w avoiding v that is
+   as short. The result is two upward graphs in CSR form:
+     up_out(u): edges u->v with rank[v] > rank[u]        (forward search)
+     up_in(u):  edges v->u with rank[v] > rank[u], to=v  (backward search)
+   The query lives next to the other algorithms: ch_search() in planner.h.
+*/
+class ContractionHierarchy {
+public:
+    ContractionHierarchy() = default;
+    // contracts g under one edge metric; queries answer for that metric only
+    void build(const Graph &g, int metric = 0);
+
+    int num_nodes() const { return (int)rank.size(); }
+    int metric() const { return metric_; }
+    size_t num_shortcuts() const { return shortcuts; }
+    int node_rank(int u) const { return rank[u]; }
+
+    const CHEdge* up_out_begin(int u) const { return out_edges.data() + out_offsets[u]; }
+    const CHEdge* up_out_end(int u) const { return out_edges.data() + out_offsets[u+1]; }
+    const CHEdge* up_in_begin(int u) const { return in_edges.data() + in_offsets[u]; }
+    const CHEdge* up_in_end(int u) const { return in_edges.data() + in_offsets[u+1]; }
+
+    // append the original nodes of edge u->v (excluding u, including v) to path
+    void unpack_edge(int u, int v, int mid, std::vector<int> &path) const;
+
+private:
+    std::vector<int> rank;
+    std::vector<int> out_offsets{0}, in_offsets{0};
+    std::vector<CHEdge> out_edges, in_edges;
+    size_t shortcuts = 0;
+    int metric_ = 0;
+};
+
+#endif // CH_H
@@ -0,0 +1,166 @@
+#include "planner.h"
+#include "parallel.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <memory>
+
+namespace {
+
+// per-worker state, padded so workers filing improved nodes do not share cache lines
+struct alignas(64) DeltaWorker {
+    std::vector<std::vector<int>> bins;  // bins[b]: nodes improved into bucket b, duplicates allowed
+    std::vector<int> settled;            // nodes of the current bucket whose heavy edges are pending
+    double weight_sum = 0.0;
+    size_t weight_count = 0, scans = 0, relaxations = 0;
+};
+
+// phases with fewer nodes than this run on the calling thread: waking the pool costs more
+const int kInlineBelow = 256;
+
+} // namespace
+
+ShortestPathTree delta_stepping(const Graph &g, int s, ThreadPool &pool, double delta, int metric) {
+    ShortestPathTree tree;
+    const int n = g.num_nodes();
+    if (s < 0 || s >= n || metric < 0 || metric >= g.num_metrics()) return tree;
+    const double INF = std::numeric_limits<double>::infinity();
+    auto t0 = std::chrono::high_resolution_clock::now();
+
+    std::vector<DeltaWorker> workers(pool.size());
+    auto run = [&](int count, int chunk, const std::function<void(int,int)> &fn) {
+        if (count < kInlineBelow) { for (int i = 0; i < count; ++i) fn(i, 0); }
+        else pool.for_each(count, chunk, fn);
+    };
+    const int node_blocks = (n + 4095) / 4096;
+    auto for_nodes = [&](const std::function<void(int,int)> &fn) {
+        pool.for_each(node_blocks, 1, [&](int b, int w) {
+            for (int v = b * 4096, e = std::min(n, v + 4096); v < e; ++v) fn(v, w);
+        });
+    };
+
+    std::unique_ptr<std::atomic<double>[]> dist(new std::atomic<double>[n]);
+    std::unique_ptr<std::atomic<int>[]> parent(new std::atomic<int>[n]);
+    std::unique_ptr<std::atomic<int>[]> filed(new std::atomic<int>[n]);  // last bucket the node joined `settled` in
+    for_nodes([&](int v, int w) {
+        dist[v].store(INF, std::memory_order_relaxed);
+        parent[v].store(-1, std::memory_order_relaxed);
+        filed[v].store(-1, std::memory_order_relaxed);
+        if (delta > 0) return;
+        for (const auto &e : g.neighbors(v, metric)) {
+            if (!std::isfinite(e.w)) continue;
+            workers[w].weight_sum += e.w;
+            workers[w].weight_count++;
+        }
+    });
+    if (!(delta > 0)) {
+        double sum = 0.0;
+        size_t count = 0;
+        for (const auto &wk : workers) { sum += wk.weight_sum; count += wk.weight_count; }
+        delta = count && sum > 0 ? sum / count : 1.0;
+    }
+    tree.delta = delta;
+
+    // lower the distance of e.to through u; the winner files the node in its bucket
+    auto relax = [&](DeltaWorker &wk, int u, double du, const Edge &e) {
+        wk.relaxations++;
+        const double nd = du + e.w;
+        double old = dist[e.to].load(std::memory_order_relaxed);
+        while (nd < old) {
+            if (!dist[e.to].compare_exchange_weak(old, nd, std::memory_order_relaxed)) continue;
+            parent[e.to].store(u, std::memory_order_relaxed);
+            const size_t b = (size_t)(nd / delta);
+            if (b >= wk.bins.size()) wk.bins.resize(b + 1);
+            wk.bins[b].push_back(e.to);
+            return;
+        }
+    };
+
+    dist[s].store(0.0, std::memory_order_relaxed);
+    workers[0].bins.assign(1, {s});
+    std::vector<int> frontier;
+    // moves every worker's share of bucket b into frontier
+    auto gather = [&](size_t b) {
+        frontier.clear();
+        for (auto &wk : workers) {
+            if (b >= wk.bins.size()) continue;
+            frontier.insert(frontier.end(), wk.bins[b].begin(), wk.bins[b].end());
+            wk.bins[b].clear();
+        }
+    };
+
+    for (size_t cur = 0; ; ++cur) {
+        size_t last = 0;
+        for (const auto &wk : workers) last = std::max(last, wk.bins.size());
+        while (cur < last) {
+            bool any = false;
+            for (const auto &wk : workers) any |= cur < wk.bins.size() && !wk.bins[cur].empty();
+            if (any) break;
+            ++cur;
+        }
+        if (cur >= last) break;
+        tree.buckets++;
+
+        // light phases: relaxing edges <= delta can refill the bucket, so repeat until it stays empty
+        for (gather(cur); !frontier.empty(); gather(cur)) {
+            tree.phases++;
+            run((int)frontier.size(), 64, [&](int i, int w) {
+                DeltaWorker &wk = workers[w];
+                const int u = frontier[i];
+                const double du = dist[u].load(std::memory_order_relaxed);
+                if ((size_t)(du / delta) != cur) return;  // stale: filed again in a lower bucket since
+                wk.scans++;
+                if (filed[u].exchange((int)cur, std::memory_order_relaxed) != (int)cur) wk.settled.push_back(u);
+                for (const auto &e : g.neighbors(u, metric))
+                    if (e.w <= delta) relax(wk, u, du, e);
+            });
+        }
+        // the bucket is final: heavy edges land in later buckets, so one pass suffices
+        frontier.clear();
+        for (auto &wk : workers) {
+            frontier.insert(frontier.end(), wk.settled.begin(), wk.settled.end());
+            wk.settled.clear();
+        }
+        run((int)frontier.size(), 64, [&](int i, int w) {
+            const int u = frontier[i];
+            const double du = dist[u].load(std::memory_order_relaxed);
+            for (const auto &e : g.neighbors(u, metric))
+                if (e.w > delta) relax(workers[w], u, du, e);
+        });
+    }
+
+    // a node improved by two workers at once may keep the parent of the larger
+    // distance; re-pick those from the tight in-edges
+    tree.dist.resize(n);
+    tree.parent.resize(n);
+    for_nodes([&](int v, int) {
+        const double dv = dist[v].load(std::memory_order_relaxed);
+        int p = parent[v].load(std::memory_order_relaxed);
+        tree.dist[v] = dv;
+        if (p >= 0) {
+            bool tight = false;
+            const double dp = dist[p].load(std::memory_order_relaxed);
+            for (const auto &e : g.neighbors(p, metric)) tight |= e.to == v && dp + e.w == dv;
+            if (!tight) {
+                p = -1;
+                for (const auto &e : g.in_neighbors(v, metric)) {
+                    if (e.to != v && dist[e.to].load(std::memory_order_relaxed) + e.w == dv) { p = e.to; break; }
+                }
+            }
+        }
+        tree.parent[v] = p;
+    });
+    for (const auto &wk : workers) {
+        tree.settled += wk.scans;
+        tree.relaxations += wk.relaxations;
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    tree.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    return tree;
+}
+
+ShortestPathTree delta_stepping(const Graph &g, int s, int threads, double delta, int metric) {
+    ThreadPool pool(threads > 0 ? threads : default_threads());
+    return delta_stepping(g, s, pool, delta, metric);
+}
@@ -1,97 +1,737 @@
 #include "graph.h"
-#include <fstream>
-#include <sstream>
+#include "mapped_file.h"
+#include "parallel.h"
+#include "planner.h"
 #include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <string_view>
+#include <atomic>
 
-static inline std::string trim(const std::string &s) {
+/* CSV ingestion
+   The file is mapped (MappedFile), cut into chunks that end on newline
+   boundaries and each chunk is parsed on its own thread with
+   std::from_chars. Chunk results are merged in file order, so node
+   overrides, edge order and the "Parse error at line N" messages are the
+   same as a sequential line-by-line read.
+*/
+namespace {
+
+struct Chunk {
+    const char *begin, *end;
+    int first_line;     // 1-based line number of the chunk's first line
+};
+
+std::vector<Chunk> split_lines(const char *b, const char *e, int parts) {
+    std::vector<Chunk> chunks;
+    size_t total = e - b;
+    size_t step = parts > 0 ? total / parts + 1 : total;
+    const char *cur = b;
+    while (cur < e) {
+        const char *stop = (size_t)(e - cur) > step ? cur + step : e;
+        while (stop < e && *(stop-1) != '\n') ++stop;
+        chunks.push_back({cur, stop, 0});
+        cur = stop;
+    }
+    // line numbers need the newline count of every earlier chunk
+    std::vector<int> newlines(chunks.size(), 0);
+    parallel_for((int)chunks.size(), parts, [&](int i) {
+        newlines[i] = (int)std::count(chunks[i].begin, chunks[i].end, '\n');
+    });
+    int line = 1;
+    for (size_t i = 0; i < chunks.size(); ++i) { chunks[i].first_line = line; line += newlines[i]; }
+    return chunks;
+}
+
+inline std::string_view next_line(const char *&p, const char *e) {
+    const char *nl = static_cast<const char*>(std::memchr(p, '\n', e - p));
+    const char *stop = nl ? nl : e;
+    std::string_view line(p, stop - p);
+    p = nl ? nl + 1 : e;
+    return line;
+}
+
+inline std::string_view trim(std::string_view s) {
     size_t a = s.find_first_not_of(" \t\r\n");
-    if (a == std::string::npos) return "";
+    if (a == std::string_view::npos) return {};
     size_t b = s.find_last_not_of(" \t\r\n");
     return s.substr(a, b-a+1);
 }
 
+// header detection: the first field of a data line only has digits, '-' and '.'
+inline bool numeric_field(std::string_view line) {
+    std::string_view first = line.substr(0, line.find(','));
+    for (char c : first) if (!(c=='-'||c=='.'||isdigit((unsigned char)c))) return false;
+    return true;
+}
+
+// parse a number prefix like std::stoi/stod or operator>> (leading blanks and '+' allowed)
+template <typename T>
+inline bool parse_number(const char *&p, const char *e, T &out) {
+    while (p < e && (*p==' '||*p=='\t')) ++p;
+    if (p < e && *p == '+') ++p;
+    auto r = std::from_chars(p, e, out);
+    if (r.ec != std::errc()) return false;
+    p = r.ptr;
+    return true;
+}
+
+template <typename T>
+inline bool parse_field(std::string_view f, T &out) {
+    const char *p = f.data();
+    return parse_number(p, f.data() + f.size(), out);
+}
+
+// a field that is a number and nothing else
+inline bool whole_number(std::string_view f) {
+    const char *p = f.data(), *e = f.data() + f.size();
+    double x;
+    return parse_number(p, e, x) && trim(std::string_view(p, e - p)).empty();
+}
+
+int load_threads(int threads, size_t bytes) {
+    if (threads <= 0) threads = default_threads();
+    // below ~1 MB per thread the thread start-up costs more than it saves
+    int useful = (int)(bytes >> 20) + 1;
+    return std::max(1, std::min(threads, useful));
+}
+
+struct NodeRecord { int id; double lat, lon; std::string_view name; };
+
+struct ParseError { int line; std::string text; };
+
+} // namespace
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// declared in planner.h; lives here because geo_scale() needs it and snapshot_convert links only the graph core
+double haversine_km(double lat1,double lon1,double lat2,double lon2){
+    // returns distance in kilometers
+    const double R = 6371.0;
+    double toRad = M_PI / 180.0;
+    double dLat = (lat2 - lat1) * toRad;
+    double dLon = (lon2 - lon1) * toRad;
+    double a = std::sin(dLat/2)*std::sin(dLat/2) +
+               std::cos(lat1*toRad)*std::cos(lat2*toRad) *
+               std::sin(dLon/2)*std::sin(dLon/2);
+    double c = 2*std::atan2(std::sqrt(a), std::sqrt(1-a));
+    return R * c;
+}
+
+Graph::Graph(const Graph &o)
+    : coords(o.coords), names(o.names), offsets(o.offsets), targets(o.targets), weights(o.weights),
+      rev_offsets(o.rev_offsets), rev_sources(o.rev_sources), rev_weights(o.rev_weights), directed_(o.directed_),
+      metric0_name(o.metric0_name), extra_metrics(o.extra_metrics),
+      mapping(o.mapping), shared_base(o.shared_base), own_weights_(o.own_weights_),
+      n_(o.n_), m_(o.m_), coords_v(o.coords_v), names_v(o.names_v), name_offsets_v(o.name_offsets_v),
+      names_blob_v(o.names_blob_v), offsets_v(o.offsets_v), targets_v(o.targets_v), weights_v(o.weights_v),
+      rev_offsets_v(o.rev_offsets_v), rev_sources_v(o.rev_sources_v), rev_weights_v(o.rev_weights_v),
+      external_ids(o.external_ids), internal_ids(o.internal_ids), version_(o.version_), geo_scales(o.geo_scales) {
+    if (!borrowed()) sync_views();
+    else if (own_weights_) sync_weight_views();
+}
+
+Graph::Graph(Graph &&o) noexcept
+    : coords(std::move(o.coords)), names(std::move(o.names)), offsets(std::move(o.offsets)),
+      targets(std::move(o.targets)), weights(std::move(o.weights)),
+      rev_offsets(std::move(o.rev_offsets)), rev_sources(std::move(o.rev_sources)), rev_weights(std::move(o.rev_weights)),
+      directed_(o.directed_), metric0_name(std::move(o.metric0_name)), extra_metrics(std::move(o.extra_metrics)),
+      mapping(std::move(o.mapping)), shared_base(std::move(o.shared_base)), own_weights_(o.own_weights_),
+      n_(o.n_), m_(o.m_), coords_v(o.coords_v), names_v(o.names_v), name_offsets_v(o.name_offsets_v),
+      names_blob_v(o.names_blob_v), offsets_v(o.offsets_v), targets_v(o.targets_v), weights_v(o.weights_v),
+      rev_offsets_v(o.rev_offsets_v), rev_sources_v(o.rev_sources_v), rev_weights_v(o.rev_weights_v),
+      external_ids(std::move(o.external_ids)), internal_ids(std::move(o.internal_ids)), version_(o.version_),
+      geo_scales(std::move(o.geo_scales)) {
+    if (!borrowed()) sync_views();
+    else if (own_weights_) sync_weight_views();
+    o.offsets.assign(1, 0);
+    o.directed_ = false;
+    o.metric0_name = "distance";
+    o.sync_views();
+}
+
+Graph& Graph::operator=(const Graph &o) {
+    if (this != &o) { Graph tmp(o); *this = std::move(tmp); }
+    return *this;
+}
+
+Graph& Graph::operator=(Graph &&o) noexcept {
+    if (this == &o) return *this;
+    coords = std::move(o.coords); names = std::move(o.names); offsets = std::move(o.offsets);
+    targets = std::move(o.targets); weights = std::move(o.weights); mapping = std::move(o.mapping);
+    shared_base = std::move(o.shared_base); own_weights_ = o.own_weights_;
+    rev_offsets = std::move(o.rev_offsets); rev_sources = std::move(o.rev_sources); rev_weights = std::move(o.rev_weights);
+    directed_ = o.directed_; metric0_name = std::move(o.metric0_name); extra_metrics = std::move(o.extra_metrics);
+    n_ = o.n_; m_ = o.m_;
+    coords_v = o.coords_v; names_v = o.names_v; name_offsets_v = o.name_offsets_v; names_blob_v = o.names_blob_v;
+    offsets_v = o.offsets_v; targets_v = o.targets_v; weights_v = o.weights_v;
+    rev_offsets_v = o.rev_offsets_v; rev_sources_v = o.rev_sources_v; rev_weights_v = o.rev_weights_v;
+    external_ids = std::move(o.external_ids); internal_ids = std::move(o.internal_ids);
+    version_ = o.version_;
+    geo_scales = std::move(o.geo_scales);
+    if (!borrowed()) sync_views();
+    else if (own_weights_) sync_weight_views();
+    o.coords.clear(); o.names.clear(); o.offsets.assign(1, 0); o.targets.clear(); o.weights.clear();
+    o.rev_offsets.clear(); o.rev_sources.clear(); o.rev_weights.clear();
+    o.directed_ = false; o.metric0_name = "distance"; o.extra_metrics.clear();
+    o.external_ids.clear(); o.internal_ids.clear();
+    o.sync_views();
+    return *this;
+}
+
+Graph::~Graph() = default;
+
+void Graph::bump_version() {
+    static std::atomic<uint64_t> next{1};
+    version_ = next++;
+    geo_scales = std::make_shared<GeoScales>(num_metrics());
+}
+
+Graph::GeoScales::GeoScales(int k): scale(new std::atomic<double>[k]), metrics(k) {
+    for (int i = 0; i < k; ++i) scale[i].store(std::numeric_limits<double>::quiet_NaN());
+}
+
+double Graph::geo_scale(int metric) const {
+    if (metric < 0 || metric >= num_metrics()) return 0.0;
+    const std::shared_ptr<GeoScales> cache = geo_scales;
+    const bool cached = cache && metric < cache->metrics;
+    if (cached) {
+        double s = cache->scale[metric].load(std::memory_order_relaxed);
+        if (!std::isnan(s)) return s;
+    }
+    double scale = std::numeric_limits<double>::infinity();
+    for (int u = 0; u < n_; ++u) {
+        for (const auto &e : neighbors(u, metric)) {
+            double km = haversine_km(coords_v[u].first, coords_v[u].second, coords_v[e.to].first, coords_v[e.to].second);
+            if (km > 0) scale = std::min(scale, e.w / km);
+        }
+    }
+    if (!std::isfinite(scale)) scale = 0.0;
+    if (cached) cache->scale[metric].store(scale, std::memory_order_relaxed);
+    return scale;
+}
+
+void Graph::sync_views() {
+    mapping.reset();
+    shared_base.reset();
+    own_weights_ = false;
+    n_ = (int)coords.size();
+    m_ = targets.size();
+    coords_v = coords.data();
+    names_v = names.data();
+    name_offsets_v = nullptr;
+    names_blob_v = nullptr;
+    offsets_v = offsets.data();
+    targets_v = targets.data();
+    rev_offsets_v = rev_offsets.data();
+    rev_sources_v = rev_sources.data();
+    sync_weight_views();
+}
+
+void Graph::sync_weight_views() {
+    weights_v = weights.data();
+    rev_weights_v = rev_weights.data();
+    for (auto &mc : extra_metrics) { mc.q_v = mc.q.data(); mc.rev_q_v = mc.rev_q.data(); }
+}
+
+void Graph::make_owned() {
+    if (!borrowed()) return;
+    coords.assign(coords_v, coords_v + n_);
+    std::vector<std::string> owned_names(n_);
+    NameTable nt = get_names();
+    for (int i = 0; i < n_; ++i) owned_names[i] = std::string(nt[i]);
+    names.swap(owned_names);
+    offsets.assign(offsets_v, offsets_v + n_ + 1);
+    targets.assign(targets_v, targets_v + m_);
+    if (directed_) {
+        rev_offsets.assign(rev_offsets_v, rev_offsets_v + n_ + 1);
+        rev_sources.assign(rev_sources_v, rev_sources_v + m_);
+    }
+    own_weights();
+    sync_views();
+}
+
+void Graph::own_weights() {
+    if (!borrowed() || own_weights_) return;
+    weights.assign(weights_v, weights_v + m_);
+    if (directed_) rev_weights.assign(rev_weights_v, rev_weights_v + m_);
+    for (auto &mc : extra_metrics) {
+        mc.q.assign(mc.q_v, mc.q_v + m_);
+        if (directed_) mc.rev_q.assign(mc.rev_q_v, mc.rev_q_v + m_);
+    }
+    own_weights_ = true;
+    sync_weight_views();
+}
+
+Graph Graph::fork(const std::shared_ptr<const Graph> &base) {
+    Graph g;
+    g.directed_ = base->directed_;
+    g.metric0_name = base->metric0_name;
+    for (const auto &mc : base->extra_metrics) {
+        MetricColumn c;
+        c.name = mc.name;
+        c.scale = mc.scale;
+        c.q_v = mc.q_v;
+        c.rev_q_v = mc.rev_q_v;
+        g.extra_metrics.push_back(std::move(c));
+    }
+    // borrow from whoever owns the arrays, so versions do not chain
+    g.mapping = base->mapping;
+    g.shared_base = base->shared_base ? base->shared_base : base->mapping ? nullptr : base;
+    g.n_ = base->n_; g.m_ = base->m_;
+    g.coords_v = base->coords_v; g.names_v = base->names_v;
+    g.name_offsets_v = base->name_offsets_v; g.names_blob_v = base->names_blob_v;
+    g.offsets_v = base->offsets_v; g.targets_v = base->targets_v; g.weights_v = base->weights_v;
+    g.rev_offsets_v = base->rev_offsets_v; g.rev_sources_v = base->rev_sources_v; g.rev_weights_v = base->rev_weights_v;
+    g.external_ids = base->external_ids;
+    g.internal_ids = base->internal_ids;
+    g.version_ = base->version_;
+    g.geo_scales = base->geo_scales;
+    g.own_weights();
+    return g;
+}
+
 bool Graph::ensure_size(int n) {
+    make_owned();
     if ((int)coords.size() >= n) return true;
     coords.resize(n, {0.0,0.0});
     names.resize(n);
-    adj.resize(n);
+    // new nodes have no edges: repeat the last offset
+    offsets.resize(n+1, offsets.back());
+    if (directed_) rev_offsets.resize(n+1, rev_offsets.back());
+    // and keep their own id in a reordered graph (external ids are a permutation of 0..n-1)
+    for (int i = (int)external_ids.size(); is_reordered() && i < n; ++i) {
+        external_ids.push_back(i);
+        internal_ids.push_back(i);
+    }
+    sync_views();
     return true;
 }
 
-bool Graph::load_nodes_csv(const std::string &nodes_csv) {
-    std::ifstream in(nodes_csv);
-    if (!in.is_open()) { std::cerr << "Failed to open: " << nodes_csv << "\n"; return false; }
-    std::string line;
-    bool header_checked = false;
-    int max_id = -1;
-    while (std::getline(in, line)) {
-        if (line.empty()) continue;
-        std::stringstream ss(line);
-        // header detection: skip first non-numeric line
-        if (!header_checked) {
-            std::string first = line.substr(0,line.find(','));
-            bool numeric = true;
-            for(char c: first) if (!(c=='-'||c=='.'||isdigit(c))) { numeric=false; break; }
-            if (!numeric) { header_checked = true; continue; }
-            header_checked = true;
+void Graph::set_node(int id, double lat, double lon, const std::string &name) {
+    if (id < 0) return;
+    ensure_size(id+1);
+    coords[id] = {lat, lon};
+    names[id] = name;
+    bump_version();
+}
+
+int Graph::find_metric(const std::string &name) const {
+    for (int k = 0; k < num_metrics(); ++k) if (metric_name(k) == name) return k;
+    int k = -1;
+    auto r = std::from_chars(name.data(), name.data() + name.size(), k);
+    if (r.ec == std::errc() && r.ptr == name.data() + name.size() && k >= 0 && k < num_metrics()) return k;
+    return -1;
+}
+
+size_t Graph::adjacency_bytes() const {
+    const size_t sides = directed_ ? 2 : 1;
+    if (borrowed())
+        return sides * ((n_+1)*sizeof(int) + m_*sizeof(int) + m_*sizeof(weight_t)) + sides * extra_metrics.size() * m_*sizeof(uint32_t);
+    size_t bytes = offsets.capacity()*sizeof(int) + targets.capacity()*sizeof(int) + weights.capacity()*sizeof(weight_t)
+                 + rev_offsets.capacity()*sizeof(int) + rev_sources.capacity()*sizeof(int) + rev_weights.capacity()*sizeof(weight_t);
+    for (const auto &mc : extra_metrics) bytes += (mc.q.capacity() + mc.rev_q.capacity()) * sizeof(uint32_t);
+    return bytes;
+}
+
+namespace {
+
+// uint32 fixed point for an extra metric: the largest finite weight (at least hi) maps to METRIC_Q_MAX
+double quantize(const std::vector<double> &w, std::vector<uint32_t> &q, double hi = 0.0) {
+    for (double x : w) if (x > hi && std::isfinite(x)) hi = x;
+    double scale = hi > 0.0 ? hi / (double)METRIC_Q_MAX : 1.0;
+    q.resize(w.size());
+    for (size_t i = 0; i < w.size(); ++i) {
+        if (w[i] == std::numeric_limits<double>::infinity()) { q[i] = METRIC_Q_INF; continue; }
+        double x = w[i] > 0.0 ? std::min(w[i], hi) : 0.0; // negative / NaN -> 0
+        q[i] = (uint32_t)std::llround(x / scale);
+    }
+    return scale;
+}
+
+uint32_t quantize_one(double w, double scale) {
+    if (w == std::numeric_limits<double>::infinity()) return METRIC_Q_INF;
+    return (uint32_t)std::min<long long>(std::llround(w / scale), METRIC_Q_MAX);
+}
+
+} // namespace
+
+/* Reversed CSR by counting sort on the target: rev_sources[k] is the
+   source of the k-th edge entering its target, in forward edge order,
+   and every metric array is permuted the same way.
+*/
+void Graph::build_reverse() {
+    const int n = n_;
+    rev_offsets.assign(n+1, 0);
+    rev_sources.assign(m_, 0);
+    rev_weights.assign(m_, 0);
+    for (auto &mc : extra_metrics) mc.rev_q.assign(m_, 0);
+    if (!directed_) {
+        rev_offsets.clear(); rev_sources.clear(); rev_weights.clear();
+        for (auto &mc : extra_metrics) mc.rev_q.clear();
+        sync_views();
+        return;
+    }
+    for (size_t k = 0; k < m_; ++k) rev_offsets[targets[k]+1]++;
+    for (int u = 0; u < n; ++u) rev_offsets[u+1] += rev_offsets[u];
+    std::vector<int> pos(rev_offsets.begin(), rev_offsets.end()-1);
+    for (int u = 0; u < n; ++u) {
+        for (int k = offsets[u]; k < offsets[u+1]; ++k) {
+            int p = pos[targets[k]]++;
+            rev_sources[p] = u;
+            rev_weights[p] = weights[k];
+            for (auto &mc : extra_metrics) mc.rev_q[p] = mc.q[k];
+        }
+    }
+    sync_views();
+}
+
+/* Rebuild the CSR arrays with the existing edges plus `edges`.
+   Counting sort by source keeps the per-node edge order stable
+   (file order, reverse arcs interleaved as they are read).
+*/
+void Graph::add_edges(const std::vector<RawEdge> &edges, bool undirected, const EdgeMetrics *metrics) {
+    make_owned();
+    int n = num_nodes();
+    for (const auto &e : edges) {
+        if (e.u < 0 || e.v < 0) continue;
+        n = std::max(n, std::max(e.u, e.v)+1);
+    }
+    ensure_size(n);
+
+    std::vector<int> count(n+1, 0);
+    for (int u = 0; u < n; ++u) count[u+1] = degree(u);
+    for (const auto &e : edges) {
+        if (e.u < 0 || e.v < 0) continue;
+        count[e.u+1]++;
+        if (undirected) count[e.v+1]++;
+    }
+    for (int u = 0; u < n; ++u) count[u+1] += count[u];
+
+    // extra metric k takes column col[k] of `metrics`, or the primary weight when -1
+    std::vector<int> col(extra_metrics.size(), -1);
+    const size_t ncols = metrics ? metrics->names.size() : 0;
+    for (size_t c = 0; c < ncols; ++c) {
+        int k = find_metric(metrics->names[c]);
+        if (k == 0) continue; // the primary weight already comes from RawEdge::w
+        if (k < 0) {
+            extra_metrics.push_back(MetricColumn());
+            extra_metrics.back().name = metrics->names[c];
+            col.push_back((int)c);
+        } else {
+            col[k-1] = (int)c;
+        }
+    }
+    const size_t nm = extra_metrics.size();
+
+    std::vector<int> new_targets(count[n]);
+    std::vector<weight_t> new_weights(count[n]);
+    std::vector<std::vector<double>> new_metrics(nm, std::vector<double>(count[n]));
+    std::vector<int> pos(count.begin(), count.end()-1);
+    for (int u = 0; u < n; ++u) {
+        for (int i = offsets[u]; i < offsets[u+1]; ++i) {
+            for (size_t k = 0; k < nm; ++k)
+                new_metrics[k][pos[u]] = extra_metrics[k].q.empty() ? (double)weights[i] : dequantize(extra_metrics[k].q[i], extra_metrics[k].scale);
+            new_targets[pos[u]] = targets[i];
+            new_weights[pos[u]++] = weights[i];
+        }
+    }
+    for (size_t i = 0; i < edges.size(); ++i) {
+        const RawEdge &e = edges[i];
+        if (e.u < 0 || e.v < 0) continue;
+        for (int end = 0; end < (undirected ? 2 : 1); ++end) {
+            int from = end ? e.v : e.u;
+            for (size_t k = 0; k < nm; ++k)
+                new_metrics[k][pos[from]] = col[k] < 0 ? e.w : metrics->values[i * ncols + col[k]];
+            new_targets[pos[from]] = end ? e.u : e.v;
+            new_weights[pos[from]++] = (weight_t)e.w;
+        }
+    }
+    offsets.swap(count);
+    targets.swap(new_targets);
+    weights.swap(new_weights);
+    for (size_t k = 0; k < nm; ++k) extra_metrics[k].scale = quantize(new_metrics[k], extra_metrics[k].q);
+    if (!undirected && !edges.empty()) directed_ = true;
+    sync_views();
+    build_reverse();
+    bump_version();
+}
+
+void Graph::set_edge_weight(int u, int v, size_t i, int metric, double w, UpdateResult &r) {
+    // twins: the reversed-CSR entries of v whose source is u
+    auto for_twins = [&](auto fn) {
+        if (!directed_) return;
+        for (int k = rev_offsets_v[v]; k < rev_offsets_v[v+1]; ++k) if (rev_sources_v[k] == u) fn(k);
+    };
+    if (metric <= 0) {
+        if (w < weights[i]) r.decreased = true;
+        weights[i] = (weight_t)w;
+        for_twins([&](int k) { rev_weights[k] = (weight_t)w; });
+    }
+    for (size_t k = 0; k < extra_metrics.size(); ++k) {
+        if (metric >= 0 && (size_t)metric != k + 1) continue;
+        MetricColumn &mc = extra_metrics[k];
+        uint32_t q = quantize_one(w, mc.scale);
+        if (q < mc.q[i]) r.decreased = true;
+        mc.q[i] = q;
+        for_twins([&](int j) { mc.rev_q[j] = q; });
+    }
+    r.edges_changed++;
+}
+
+/* Batch updates. Weight changes and closures only rewrite the entries of
+   the edges involved; insertions need new CSR slots and go through
+   add_edges() once for the whole batch. A new weight above an extra
+   metric's range re-encodes that column (O(m)) before it is written.
+   Without either, a borrowed graph (snapshot, fork) copies its weights
+   only and keeps reading the topology through the views.
+*/
+UpdateResult Graph::apply_updates(const std::vector<EdgeUpdate> &batch, int metric) {
+    UpdateResult r;
+    if (metric < 0 || metric >= num_metrics()) { r.missing = batch.size(); return r; }
+    own_weights();
+    // geo_scale() values known before the batch, carried to the new version below
+    const std::shared_ptr<GeoScales> old_scales = geo_scales;
+    const int old_metrics = num_metrics();
+    bool requantized_metric = false;
+    const double INF = std::numeric_limits<double>::infinity();
+    auto valid = [&](const EdgeUpdate &up) {
+        return up.u >= 0 && up.u < n_ && up.v >= 0 && up.v < n_ && (up.kind == EdgeUpdate::Close || up.w >= 0);
+    };
+
+    std::vector<RawEdge> inserts;
+    for (const auto &up : batch) {
+        if (up.kind != EdgeUpdate::Insert) continue;
+        if (!valid(up)) { r.missing++; continue; }
+        inserts.push_back({up.u, up.v, up.w});
+    }
+    if (!inserts.empty()) {
+        size_t before = m_;
+        add_edges(inserts, !directed_);
+        r.applied += inserts.size();
+        r.edges_changed += m_ - before;
+        r.rebuilt = r.decreased = true;
+    }
+
+    if (metric > 0) {
+        MetricColumn &mc = extra_metrics[metric-1];
+        double hi = 0.0;
+        for (const auto &up : batch)
+            if (up.kind == EdgeUpdate::Set && valid(up) && std::isfinite(up.w)) hi = std::max(hi, up.w);
+        if (hi > mc.scale * METRIC_Q_MAX) {
+            make_owned();
+            std::vector<double> values(m_);
+            for (size_t i = 0; i < m_; ++i) values[i] = dequantize(mc.q[i], mc.scale);
+            mc.scale = quantize(values, mc.q, hi);
+            build_reverse();
+            r.requantized = requantized_metric = true;
+        }
+    }
+
+    for (const auto &up : batch) {
+        if (up.kind == EdgeUpdate::Insert) continue;
+        if (!valid(up)) { r.missing++; continue; }
+        const bool close = up.kind == EdgeUpdate::Close;
+        const size_t before = r.edges_changed;
+        // undirected graphs hold v->u as a forward entry of v
+        for (int end = 0; end < (directed_ || up.u == up.v ? 1 : 2); ++end) {
+            int a = end ? up.v : up.u, b = end ? up.u : up.v;
+            for (int i = offsets_v[a]; i < offsets_v[a+1]; ++i)
+                if (targets_v[i] == b) set_edge_weight(a, b, i, close ? -1 : metric, close ? INF : up.w, r);
         }
-        int id; double lat, lon;
-        if (!(ss >> id)) continue;
-        if (ss.peek() == ',') ss.get();
-        if (!(ss >> lat)) continue;
-        if (ss.peek() == ',') ss.get();
-        if (!(ss >> lon)) continue;
-        if (ss.peek() == ',') ss.get();
-        std::string rest; std::getline(ss, rest);
-        std::string name = trim(rest);
-        if (id > max_id) max_id = id;
-        ensure_size(max_id+1);
-        coords[id] = {lat, lon};
-        names[id] = name;
+        if (r.edges_changed == before) r.missing++;
+        else r.applied++;
     }
+    if (!r.applied) return r;
+    bump_version();
+    // new ratios can only come from the edges written (closed ones are +inf); the stored
+    // weights are read back, so quantization is accounted for. A re-encoded column rescans.
+    if (!old_scales || old_metrics != num_metrics()) return r;
+    for (int k = 0; k < old_metrics; ++k) {
+        double s = old_scales->scale[k].load(std::memory_order_relaxed);
+        if (std::isnan(s) || (k == metric && requantized_metric)) continue;
+        for (const auto &up : batch) {
+            if (up.kind == EdgeUpdate::Close || !valid(up) || (up.kind == EdgeUpdate::Set && k != metric)) continue;
+            const double km = haversine_km(coords_v[up.u].first, coords_v[up.u].second, coords_v[up.v].first, coords_v[up.v].second);
+            if (!(km > 0)) continue;
+            for (const auto &e : neighbors(up.u, k))
+                if (e.to == up.v) s = std::min(s, e.w / km);
+            if (!directed_)
+                for (const auto &e : neighbors(up.v, k))
+                    if (e.to == up.u) s = std::min(s, e.w / km);
+        }
+        geo_scales->scale[k].store(s, std::memory_order_relaxed);
+    }
+    return r;
+}
+
+bool Graph::load_nodes_csv(const std::string &nodes_csv, int threads) {
+    MappedFile file;
+    if (!file.open(nodes_csv)) { std::cerr << "Failed to open: " << nodes_csv << "\n"; return false; }
+    make_owned();
+    const char *b = file.data(), *e = b + file.size();
+    threads = load_threads(threads, file.size());
+    std::vector<Chunk> chunks = split_lines(b, e, threads * 4);
+    std::vector<std::vector<NodeRecord>> parsed(chunks.size());
+
+    parallel_for((int)chunks.size(), threads, [&](int ci) {
+        const Chunk &c = chunks[ci];
+        auto &out = parsed[ci];
+        // header detection: skip first non-numeric line (only the file's first chunk can hold it)
+        bool header_checked = ci != 0;
+        for (const char *p = c.begin; p < c.end; ) {
+            std::string_view line = next_line(p, c.end);
+            if (line.empty()) continue;
+            if (!header_checked) {
+                header_checked = true;
+                if (!numeric_field(line)) continue;
+            }
+            const char *q = line.data(), *le = q + line.size();
+            NodeRecord r;
+            if (!parse_number(q, le, r.id)) continue;
+            if (q < le && *q == ',') ++q;
+            if (!parse_number(q, le, r.lat)) continue;
+            if (q < le && *q == ',') ++q;
+            if (!parse_number(q, le, r.lon)) continue;
+            if (q < le && *q == ',') ++q;
+            if (r.id < 0) continue;
+            r.name = trim(std::string_view(q, le - q));
+            out.push_back(r);
+        }
+    });
+
+    int max_id = num_nodes() - 1;
+    for (const auto &chunk : parsed)
+        for (const auto &r : chunk) max_id = std::max(max_id, r.id);
     if (max_id >= 0) ensure_size(max_id+1);
+    for (const auto &chunk : parsed) {
+        for (const auto &r : chunk) {
+            coords[r.id] = {r.lat, r.lon};
+            names[r.id].assign(r.name.data(), r.name.size());
+        }
+    }
+    bump_version();
     return true;
 }
 
-bool Graph::load_edges_csv(const std::string &edges_csv, bool undirected) {
-    std::ifstream in(edges_csv);
-    if (!in.is_open()) { std::cerr << "Failed to open: " << edges_csv << "\n"; return false; }
-    std::string line;
-    bool header_checked = false;
-    int line_num = 0;
-    while (std::getline(in, line)) {
-        ++line_num;
-        if (line.empty()) continue;
-        // Skip header
-        if (!header_checked) {
-            std::stringstream ss(line);
-            std::string first;
-            std::getline(ss, first, ',');
-            bool numeric = true;
-            for(char c: first) if (!(c=='-'||c=='.'||isdigit(c))) { numeric=false; break; }
-            if (!numeric) { header_checked = true; continue; }
-            header_checked = true;
+bool Graph::load_edges_csv(const std::string &edges_csv, bool undirected, int threads) {
+    MappedFile file;
+    if (!file.open(edges_csv)) { std::cerr << "Failed to open: " << edges_csv << "\n"; return false; }
+    const char *b = file.data(), *e = b + file.size();
+
+    // columns after the weight that hold a number in the first data row are extra metrics,
+    // named by the header (metric<k> without one); other columns (road names, ...) are ignored
+    EdgeMetrics metrics;
+    std::vector<int> metric_fields;  // field index of each extra metric, ascending
+    std::string weight_name;
+    std::vector<std::string> header_names;
+    bool first = true;
+    for (const char *p = b; p < e; ) {
+        std::string_view line = next_line(p, e);
+        if (trim(line).empty()) continue;
+        const bool header = first && !numeric_field(line);
+        first = false;
+        int field = 0;
+        for (size_t start = 0; start <= line.size(); ++field) {
+            size_t comma = line.find(',', start);
+            std::string_view f = trim(line.substr(start, comma == std::string_view::npos ? std::string_view::npos : comma - start));
+            if (header) header_names.emplace_back(f);
+            else if (field >= 3 && whole_number(f)) {
+                metric_fields.push_back(field);
+                metrics.names.push_back(field < (int)header_names.size() ? header_names[field] : "metric" + std::to_string(field - 2));
+            }
+            if (comma == std::string_view::npos) break;
+            start = comma + 1;
         }
-        std::stringstream ss(line);
-        std::string u_str, v_str, w_str;
-        if (!std::getline(ss, u_str, ',')) { std::cerr << "Parse error at line " << line_num << "\n"; continue; }
-        if (!std::getline(ss, v_str, ',')) { std::cerr << "Parse error at line " << line_num << "\n"; continue; }
-        if (!std::getline(ss, w_str, ',')) { std::cerr << "Parse error at line " << line_num << "\n"; continue; }
-        int u = -1, v = -1;
-        double w = 0.0;
-        try {
-            u = std::stoi(u_str);
-            v = std::stoi(v_str);
-            w = std::stod(w_str);
-        } catch (...) {
-            std::cerr << "Parse error at line " << line_num << ": " << line << "\n";
-            continue;
+        if (!header) break;
+    }
+    if (header_names.size() > 2) weight_name = header_names[2];
+    const size_t ncols = metrics.names.size();
+
+    threads = load_threads(threads, file.size());
+    std::vector<Chunk> chunks = split_lines(b, e, threads * 4);
+    std::vector<std::vector<RawEdge>> parsed(chunks.size());
+    std::vector<std::vector<double>> parsed_metrics(chunks.size());
+    std::vector<std::vector<ParseError>> errors(chunks.size());
+
+    parallel_for((int)chunks.size(), threads, [&](int ci) {
+        const Chunk &c = chunks[ci];
+        auto &out = parsed[ci];
+        auto &errs = errors[ci];
+        out.reserve((c.end - c.begin) / 12);
+        bool header_checked = ci != 0;
+        int line_num = c.first_line - 1;
+        for (const char *p = c.begin; p < c.end; ) {
+            std::string_view line = next_line(p, c.end);
+            ++line_num;
+            if (line.empty()) continue;
+            // Skip header
+            if (!header_checked) {
+                header_checked = true;
+                if (!numeric_field(line)) continue;
+            }
+            size_t c1 = line.find(',');
+            size_t c2 = c1 == std::string_view::npos ? c1 : line.find(',', c1+1);
+            if (c2 == std::string_view::npos || c2+1 >= line.size()) { errs.push_back({line_num, ""}); continue; }
+            size_t c3 = line.find(',', c2+1);
+            std::string_view u_str = line.substr(0, c1);
+            std::string_view v_str = line.substr(c1+1, c2-c1-1);
+            std::string_view w_str = line.substr(c2+1, c3 == std::string_view::npos ? std::string_view::npos : c3-c2-1);
+            RawEdge r;
+            if (!parse_field(u_str, r.u) || !parse_field(v_str, r.v) || !parse_field(w_str, r.w)) {
+                errs.push_back({line_num, std::string(line)});
+                continue;
+            }
+            auto &vals = parsed_metrics[ci];
+            size_t start = c3, k = 0;
+            for (int field = 3; k < ncols && start != std::string_view::npos; ++field) {
+                size_t next = line.find(',', start+1);
+                if (field == metric_fields[k]) {
+                    double x;
+                    if (!parse_field(line.substr(start+1, next == std::string_view::npos ? next : next-start-1), x)) break;
+                    vals.push_back(x);
+                    ++k;
+                }
+                start = next;
+            }
+            if (k < ncols) {
+                vals.resize(vals.size() - k);
+                errs.push_back({line_num, std::string(line)});
+                continue;
+            }
+            if (r.u < 0 || r.v < 0) { vals.resize(vals.size() - ncols); continue; }
+            out.push_back(r);
         }
-        if (u < 0 || v < 0) continue;
-        int needed = std::max(u,v)+1;
-        ensure_size(needed);
-        adj[u].push_back(Edge(v,w));
-        if (undirected) adj[v].push_back(Edge(u,w));
+    });
+
+    size_t total = 0, failed = 0;
+    for (size_t ci = 0; ci < chunks.size(); ++ci) {
+        total += parsed[ci].size();
+        failed += errors[ci].size();
+        for (const auto &err : errors[ci]) {
+            std::cerr << "Parse error at line " << err.line;
+            if (!err.text.empty()) std::cerr << ": " << err.text;
+            std::cerr << "\n";
+        }
+    }
+    std::vector<RawEdge> raw;
+    raw.reserve(total);
+    metrics.values.reserve(total * ncols);
+    for (size_t ci = 0; ci < chunks.size(); ++ci) {
+        raw.insert(raw.end(), parsed[ci].begin(), parsed[ci].end());
+        std::vector<RawEdge>().swap(parsed[ci]);
+        metrics.values.insert(metrics.values.end(), parsed_metrics[ci].begin(), parsed_metrics[ci].end());
+        std::vector<double>().swap(parsed_metrics[ci]);
+    }
+    if (total == 0 && failed > 0) {
+        std::cerr << "No edge could be parsed from " << edges_csv << "\n";
+        return false;
     }
+    if (!weight_name.empty()) metric0_name = weight_name;
+    add_edges(raw, undirected, ncols ? &metrics : nullptr);
     return true;
 }
@@ -3,7 +3,24 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <utility>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <atomic>
+
+class MappedFile;
+
+// Edge weights are stored as weight_t in the CSR arrays. Build with
+// -DROUTE_FLOAT_WEIGHTS to halve the weight array on very large graphs;
+// searches still accumulate distances in double.
+#ifdef ROUTE_FLOAT_WEIGHTS
+using weight_t = float;
+#else
+using weight_t = double;
+#endif
 
 struct Edge {
     int to;
@@ -11,23 +28,314 @@ struct Edge {
     Edge(int _to=-1,double _w=0.0): to(_to), w(_w) {}
 };
 
+// input edge as read from routes.csv, before CSR construction
+struct RawEdge {
+    int u, v;
+    double w;
+};
+
+// extra weight columns for Graph::add_edges: values[i * names.size() + k]
+// is metric `names[k]` of edge i (travel time next to length, ...)
+struct EdgeMetrics {
+    std::vector<std::string> names;
+    std::vector<double> values;
+};
+
+// quantized metric value of a closed edge (weight +inf); finite weights use 0 .. METRIC_Q_MAX
+constexpr uint32_t METRIC_Q_INF = UINT32_MAX;
+constexpr uint32_t METRIC_Q_MAX = UINT32_MAX - 1;
+inline double dequantize(uint32_t q, double scale) {
+    return q == METRIC_Q_INF ? std::numeric_limits<double>::infinity() : q * scale;
+}
+
+// Range over the outgoing edges of one node in the CSR arrays, weighted by
+// either the full-precision weights or a quantized metric (q * scale).
+// Iteration yields Edge by value so `for (const auto &e : g.neighbors(u))` works.
+class EdgeRange {
+public:
+    class iterator {
+    public:
+        iterator(const int *to, const weight_t *w, const uint32_t *q, double scale, int i)
+            : to_(to), w_(w), q_(q), scale_(scale), i_(i) {}
+        Edge operator*() const { return Edge(to_[i_], q_ ? dequantize(q_[i_], scale_) : (double)w_[i_]); }
+        iterator& operator++() { ++i_; return *this; }
+        bool operator!=(const iterator &o) const { return i_ != o.i_; }
+        bool operator==(const iterator &o) const { return i_ == o.i_; }
+    private:
+        const int *to_;
+        const weight_t *w_;
+        const uint32_t *q_;
+        double scale_;
+        int i_;
+    };
+
+    EdgeRange(const int *to, const weight_t *w, int count): to_(to), w_(w), q_(nullptr), scale_(1.0), count_(count) {}
+    EdgeRange(const int *to, const uint32_t *q, double scale, int count): to_(to), w_(nullptr), q_(q), scale_(scale), count_(count) {}
+    iterator begin() const { return iterator(to_, w_, q_, scale_, 0); }
+    iterator end() const { return iterator(to_, w_, q_, scale_, count_); }
+    int size() const { return count_; }
+    bool empty() const { return count_ == 0; }
+
+private:
+    const int *to_;
+    const weight_t *w_;
+    const uint32_t *q_;
+    double scale_;
+    int count_;
+};
+
+// one change for Graph::apply_updates (internal ids)
+struct EdgeUpdate {
+    enum Kind { Set, Insert, Close };
+    Kind kind;
+    int u, v;
+    double w = 0.0;     // new weight (Set: of the chosen metric, Insert: of every metric)
+};
+
+struct UpdateResult {
+    size_t applied = 0;        // updates that took effect
+    size_t missing = 0;        // Set / Close of an edge that does not exist, Insert of an unknown node, negative weights
+    size_t edges_changed = 0;  // forward CSR entries written (both directions of an undirected edge, parallel edges)
+    bool decreased = false;    // a weight went down or an edge was added: earlier lower bounds (ALT) may not hold
+    bool rebuilt = false;      // insertions rebuilt the CSR arrays
+    bool requantized = false;  // a weight outside an extra metric's range re-encoded the column
+};
+
+// non-owning view of a contiguous array (owned vector or mapped snapshot)
+template <typename T>
+class ArrayView {
+public:
+    ArrayView(const T *p = nullptr, size_t n = 0): p_(p), n_(n) {}
+    const T& operator[](size_t i) const { return p_[i]; }
+    const T* data() const { return p_; }
+    size_t size() const { return n_; }
+    bool empty() const { return n_ == 0; }
+    const T* begin() const { return p_; }
+    const T* end() const { return p_ + n_; }
+private:
+    const T *p_;
+    size_t n_;
+};
+
+// node names, either owned strings or an offsets + blob pair from a snapshot
+class NameTable {
+public:
+    NameTable(const std::string *strs, const uint64_t *offs, const char *blob, size_t n)
+        : strs_(strs), offs_(offs), blob_(blob), n_(n) {}
+    std::string_view operator[](size_t i) const {
+        if (strs_) return strs_[i];
+        return std::string_view(blob_ + offs_[i], offs_[i+1] - offs_[i]);
+    }
+    size_t size() const { return n_; }
+private:
+    const std::string *strs_;
+    const uint64_t *offs_;
+    const char *blob_;
+    size_t n_;
+};
+
+// node numbering used internally, see Graph::reorder()
+enum class NodeOrder { Input, Hilbert, Bfs };
+const char* node_order_name(NodeOrder o);
+bool parse_node_order(const std::string &s, NodeOrder &out);
+class Graph;
+// positions into nodes, ordered along the Hilbert curve that NodeOrder::Hilbert uses
+// (nearby nodes end up next to each other; invalid ids last)
+std::vector<int> hilbert_sort(const Graph &g, const std::vector<int> &nodes);
+
+/* Graph in Compressed Sparse Row layout:
+   the edges of node u are targets[offsets[u] .. offsets[u+1]) with the
+   matching weights. The arrays are built once at load time and never
+   modified by the searches.
+   The arrays are either owned (CSV loading, programmatic construction) or
+   served straight from a mmap'ed binary snapshot; accessors only see
+   the views, so both cases look the same to the algorithms (a third
+   case, a fork() sharing another version's arrays, works the same way).
+   Mutating a snapshot-backed graph first copies it into owned storage.
+
+   Metrics: metric 0 is the full-precision weight array. Further cost
+   functions over the same topology (travel time next to length) are
+   stored as uint32 fixed point, weight = q * scale with scale = largest
+   weight / METRIC_Q_MAX, so each costs 4 bytes per edge and a weight is off
+   by at most scale / 2; METRIC_Q_INF marks a closed edge. Searches pick one
+   at runtime (neighbors(u, metric)).
+
+   Updates: apply_updates() changes weights and closes edges in place
+   (O(degree) per update) and inserts edges with one CSR rebuild per
+   batch. Graphs being searched concurrently are updated through
+   GraphVersions (graph_updates.h) instead, which copies the weights on
+   write via fork().
+
+   Direction: a graph becomes directed once edges are added without their
+   reverse; it then also keeps the reversed CSR (with all metrics) for
+   backward searches through in_neighbors(). For undirected graphs
+   in_neighbors() is neighbors().
+*/
 class Graph {
 public:
-    Graph() = default;
-    bool load_nodes_csv(const std::string &nodes_csv);
-    bool load_edges_csv(const std::string &edges_csv, bool undirected = true);
+    Graph() { sync_views(); }
+    Graph(const Graph &o);
+    Graph(Graph &&o) noexcept;
+    Graph& operator=(const Graph &o);
+    Graph& operator=(Graph &&o) noexcept;
+    ~Graph();
+
+    // CSV loaders parse the file in parallel chunks; threads <= 0 uses all cores
+    bool load_nodes_csv(const std::string &nodes_csv, int threads = 0);
+    bool load_edges_csv(const std::string &edges_csv, bool undirected = true, int threads = 0);
+
+    // binary snapshot (see snapshot.cpp for the layout); load maps the file
+    // and serves the arrays without copying. verify recomputes the checksum.
+    bool save_snapshot(const std::string &path) const;
+    bool load_snapshot(const std::string &path, bool verify = true);
+    static bool is_snapshot(const std::string &path);
+
+    // programmatic construction (tests, benchmarks, generators).
+    // metrics adds or extends extra metric columns (see above); edges without
+    // a value for an extra metric, including all earlier edges when a new
+    // metric appears, take their primary weight w.
+    void set_node(int id, double lat, double lon, const std::string &name = "");
+    void add_edges(const std::vector<RawEdge> &edges, bool undirected = true, const EdgeMetrics *metrics = nullptr);
+
+    /* Apply a batch of edge changes; Set / Close act on every u->v edge (and
+       v->u on undirected graphs). Insertions go first, as one rebuild, then
+       the weight changes and closures in batch order. Close sets every metric
+       to +inf, which the searches never relax; a later Set reopens the edge.
+       Set changes `metric` only; an inserted edge gets w for every metric.
+       Bumps version(), so caches, profiles and geographic bounds of the old
+       version are dropped; CH and landmarks built earlier are not updated. */
+    UpdateResult apply_updates(const std::vector<EdgeUpdate> &batch, int metric = 0);
+    /* Next version of base for copy-on-write updates: reads base's
+       topology, coordinates and names in place (keeping the graph that owns
+       them alive) and copies only the weight arrays, which is all that
+       weight changes and closures write. Insertions make it fully owned. */
+    static Graph fork(const std::shared_ptr<const Graph> &base);
+
+    /* Renumber nodes for memory locality (call after loading): Hilbert sorts
+       by the Hilbert-curve index of the coordinates, Bfs is a Cuthill-McKee
+       breadth-first order. All accessors and searches then use internal ids;
+       to_internal()/to_external() translate ids from and to the input files,
+       so CLI arguments and printed ids stay the same. The mapping is saved
+       with snapshots. */
+    void reorder(NodeOrder order);
+    int to_internal(int external_id) const { return internal_ids.empty() ? external_id : internal_ids[external_id]; }
+    int to_external(int internal_id) const { return external_ids.empty() ? internal_id : external_ids[internal_id]; }
+    bool is_reordered() const { return !external_ids.empty(); }
 
-    int num_nodes() const { return (int)coords.size(); }
-    const std::vector<std::pair<double,double>>& get_coords() const { return coords; } // (lat, lon)
-    const std::vector<std::string>& get_names() const { return names; }
-    const std::vector<std::vector<Edge>>& adjacency() const { return adj; }
+    // changes whenever the graph is loaded or modified (unique across Graph objects); copies keep it
+    uint64_t version() const { return version_; }
+
+    /* Smallest weight / km ratio over the edges of one metric, which makes
+       scale * great-circle km a consistent A* potential. The first call scans
+       every edge (O(m) haversines, without a lock: concurrent first callers
+       may both scan); copies share the result. fork() + apply_updates()
+       carry it forward as min(old, ratio of every edge set or inserted),
+       raised weights keeping the old value admissible, so new versions do
+       not rescan. Other modifications drop it. */
+    double geo_scale(int metric = 0) const;
+
+    int num_nodes() const { return n_; }
+    size_t num_edges() const { return m_; }
+    ArrayView<std::pair<double,double>> get_coords() const { return {coords_v, (size_t)n_}; } // (lat, lon)
+    NameTable get_names() const { return NameTable(names_v, name_offsets_v, names_blob_v, n_); }
+
+    EdgeRange neighbors(int u, int metric = 0) const {
+        int b = offsets_v[u], e = offsets_v[u+1];
+        if (metric == 0) return EdgeRange(targets_v + b, weights_v + b, e - b);
+        const MetricColumn &mc = extra_metrics[metric-1];
+        return EdgeRange(targets_v + b, mc.q_v + b, mc.scale, e - b);
+    }
+    // edges v->u as (v, w): the reversed graph, for backward searches
+    EdgeRange in_neighbors(int u, int metric = 0) const {
+        if (!directed_) return neighbors(u, metric);
+        int b = rev_offsets_v[u], e = rev_offsets_v[u+1];
+        if (metric == 0) return EdgeRange(rev_sources_v + b, rev_weights_v + b, e - b);
+        const MetricColumn &mc = extra_metrics[metric-1];
+        return EdgeRange(rev_sources_v + b, mc.rev_q_v + b, mc.scale, e - b);
+    }
+    int degree(int u) const { return offsets_v[u+1] - offsets_v[u]; }
+    bool is_directed() const { return directed_; }
+
+    // metric 0 is named by the weight column header ("distance" by default)
+    int num_metrics() const { return 1 + (int)extra_metrics.size(); }
+    const std::string& metric_name(int metric) const { return metric == 0 ? metric0_name : extra_metrics[metric-1].name; }
+    // index of a metric by name or number, -1 when there is none
+    int find_metric(const std::string &name) const;
+
+    // raw CSR arrays, for kernels that want to index directly
+    ArrayView<int> edge_offsets() const { return {offsets_v, (size_t)n_+1}; }
+    ArrayView<int> edge_targets() const { return {targets_v, m_}; }
+    ArrayView<weight_t> edge_weights() const { return {weights_v, m_}; }
+
+    // bytes held by the topology arrays (offsets + targets + weights, reversed CSR and extra metrics included)
+    size_t adjacency_bytes() const;
+    bool is_mapped() const { return (bool)mapping; }
 
 private:
+    // owned storage
     std::vector<std::pair<double,double>> coords;
     std::vector<std::string> names;
-    std::vector<std::vector<Edge>> adj;
+    std::vector<int> offsets{0};   // size num_nodes()+1
+    std::vector<int> targets;
+    std::vector<weight_t> weights;
+    // reversed CSR, directed graphs only
+    std::vector<int> rev_offsets, rev_sources;
+    std::vector<weight_t> rev_weights;
+    bool directed_ = false;
+
+    struct MetricColumn {
+        std::string name;
+        double scale = 1.0;
+        std::vector<uint32_t> q, rev_q;      // owned, CSR / reversed CSR order
+        const uint32_t *q_v = nullptr, *rev_q_v = nullptr;
+    };
+    std::string metric0_name = "distance";
+    std::vector<MetricColumn> extra_metrics;
+
+    // snapshot storage: the views point into the mapping
+    std::shared_ptr<MappedFile> mapping;
+    // fork(): the views point into the owned storage of an earlier version,
+    // except for the weights when own_weights_
+    std::shared_ptr<const Graph> shared_base;
+    bool own_weights_ = false;
+
+    // views used by every accessor
+    int n_ = 0;
+    size_t m_ = 0;
+    const std::pair<double,double> *coords_v = nullptr;
+    const std::string *names_v = nullptr;   // owned names, or null for the blob below
+    const uint64_t *name_offsets_v = nullptr;
+    const char *names_blob_v = nullptr;
+    const int *offsets_v = nullptr;
+    const int *targets_v = nullptr;
+    const weight_t *weights_v = nullptr;
+    const int *rev_offsets_v = nullptr;
+    const int *rev_sources_v = nullptr;
+    const weight_t *rev_weights_v = nullptr;
+
+    // id mapping after reorder(), empty for the identity
+    std::vector<int> external_ids;  // internal -> external
+    std::vector<int> internal_ids;  // external -> internal
+    uint64_t version_ = 0;
+    // geo_scale() per metric, NaN until computed; replaced whenever the version changes
+    struct GeoScales {
+        explicit GeoScales(int metrics);
+        std::unique_ptr<std::atomic<double>[]> scale;
+        int metrics;
+    };
+    mutable std::shared_ptr<GeoScales> geo_scales;
+
+    void bump_version();
 
     bool ensure_size(int n);
+    bool borrowed() const { return mapping || shared_base; }
+    void sync_views();     // point the views at the owned storage
+    void make_owned();     // copy a mapped snapshot or shared version into owned storage
+    void own_weights();    // copy just the weight arrays (all metrics) of a borrowed graph
+    void sync_weight_views();
+    void build_reverse();  // rev_* arrays from the forward CSR (directed graphs)
+    // write w to forward entry i of u->v and its reversed twins, for one metric or every metric (-1)
+    void set_edge_weight(int u, int v, size_t i, int metric, double w, UpdateResult &r);
 };
 
 #endif // GRAPH_H
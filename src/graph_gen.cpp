@@ -0,0 +1,80 @@
+// graph_gen.cpp
+// writes a synthetic graph (see synthetic.h) as a binary snapshot or a cities.csv / routes.csv pair
+#include "graph.h"
+#include "io.h"
+#include "synthetic.h"
+#include "time_profiles.h"
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <vector>
+
+// value of `--name value` anywhere in argv, or def
+static std::string flag_value(int argc, char** argv, const std::string &name, const std::string &def) {
+    for (int i = 1; i+1 < argc; ++i) if (argv[i] == name) return argv[i+1];
+    return def;
+}
+
+static bool ends_with(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() && s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> pos;
+    for (int i = 1; i < argc; ++i) {
+        if (std::string(argv[i]).rfind("--", 0) == 0) { ++i; continue; }
+        pos.push_back(argv[i]);
+    }
+    bool csv = pos.size() >= 3 && ends_with(pos[2], ".csv");
+    if (pos.size() < 3 || (csv && pos.size() < 4)) {
+        std::cout << "Usage: " << argv[0] << " <grid|geometric|road> <nodes> <out.rpg> | <cities.csv> <routes.csv>\n"
+                  << "       [--seed S] [--center lat,lon] [--spacing km] [--k K] [--jitter f] [--arterial A] [--reorder hilbert|bfs]\n"
+                  << "       [--profiles out.csv]\n";
+        return 1;
+    }
+    SyntheticOptions opt;
+    if (!parse_synthetic_kind(pos[0], opt.kind)) { std::cerr << "Unknown graph kind: " << pos[0] << "\n"; return 1; }
+    opt.nodes = std::stoi(pos[1]);
+    opt.seed = std::stoul(flag_value(argc, argv, "--seed", "1"));
+    std::string center = flag_value(argc, argv, "--center", "");
+    if (!center.empty()) {
+        size_t comma = center.find(',');
+        if (comma == std::string::npos) { std::cerr << "--center expects lat,lon\n"; return 1; }
+        opt.center_lat = std::stod(center.substr(0, comma));
+        opt.center_lon = std::stod(center.substr(comma + 1));
+    }
+    opt.spacing_km = std::stod(flag_value(argc, argv, "--spacing", std::to_string(opt.spacing_km)));
+    opt.k_nearest = std::stoi(flag_value(argc, argv, "--k", std::to_string(opt.k_nearest)));
+    opt.jitter = std::stod(flag_value(argc, argv, "--jitter", std::to_string(opt.jitter)));
+    opt.arterial = std::stoi(flag_value(argc, argv, "--arterial", std::to_string(opt.arterial)));
+    NodeOrder order = NodeOrder::Input;
+    std::string order_name = flag_value(argc, argv, "--reorder", "input");
+    if (!parse_node_order(order_name, order)) { std::cerr << "Unknown order: " << order_name << "\n"; return 1; }
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    Graph g = make_synthetic_graph(opt);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    g.reorder(order);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    if (csv) {
+        if (!write_graph_csv(g, pos[2], pos[3])) return 2;
+    } else {
+        if (!g.save_snapshot(pos[2])) return 2;
+    }
+    // rush-hour travel-time profiles for the time-dependent searches (seconds of the day)
+    std::string profiles_csv = flag_value(argc, argv, "--profiles", "");
+    if (!profiles_csv.empty()) {
+        std::vector<ProfileRow> rows = make_synthetic_profiles(g, opt.seed);
+        // the loaders reject what build() rejects, so never write such a file
+        TravelTimeProfiles check;
+        if (!check.build(g, rows)) { std::cerr << "Generated profiles are invalid, not writing " << profiles_csv << "\n"; return 2; }
+        if (!write_profiles_csv(g, rows, profiles_csv)) return 2;
+        std::cout << "Wrote " << profiles_csv << "\n";
+    }
+    auto t3 = std::chrono::high_resolution_clock::now();
+    auto ms = [](auto a, auto b) { return std::chrono::duration<double, std::milli>(b - a).count(); };
+    std::cout << "Wrote " << (csv ? pos[2] + " and " + pos[3] : pos[2]) << ": " << synthetic_kind_name(opt.kind)
+              << " nodes=" << g.num_nodes() << " edges=" << g.num_edges() << " order=" << node_order_name(order) << "\n";
+    std::cout << "generate_ms=" << ms(t0, t1) << " reorder_ms=" << ms(t1, t2) << " write_ms=" << ms(t2, t3) << "\n";
+    return 0;
+}
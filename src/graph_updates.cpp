@@ -0,0 +1,79 @@
+#include "graph_updates.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+bool parse_update(const std::string &line, const Graph &g, EdgeUpdate &out) {
+    std::istringstream in(line);
+    std::string op;
+    long long u, v;
+    if (!(in >> op >> u >> v)) return false;
+    EdgeUpdate up;
+    if (op == "set") up.kind = EdgeUpdate::Set;
+    else if (op == "close") up.kind = EdgeUpdate::Close;
+    else if (op == "insert") up.kind = EdgeUpdate::Insert;
+    else return false;
+    if (up.kind != EdgeUpdate::Close && !(in >> up.w)) return false;
+    if (u < 0 || v < 0 || u >= g.num_nodes() || v >= g.num_nodes()) return false;
+    up.u = g.to_internal((int)u);
+    up.v = g.to_internal((int)v);
+    out = up;
+    return true;
+}
+
+bool load_update_stream(const std::string &path, const Graph &g, std::vector<std::vector<EdgeUpdate>> &batches) {
+    std::ifstream in(path);
+    if (!in.is_open()) { std::cerr << "Failed to open: " << path << "\n"; return false; }
+    batches.assign(1, {});
+    std::string line;
+    for (int line_num = 1; std::getline(in, line); ++line_num) {
+        size_t a = line.find_first_not_of(" \t\r");
+        if (a == std::string::npos || line[a] == '#') continue;
+        if (line.compare(a, 6, "commit") == 0) {
+            if (!batches.back().empty()) batches.emplace_back();
+            continue;
+        }
+        EdgeUpdate up;
+        if (!parse_update(line, g, up)) { std::cerr << "Parse error at line " << line_num << ": " << line << "\n"; continue; }
+        batches.back().push_back(up);
+    }
+    if (batches.back().empty()) batches.pop_back();
+    return true;
+}
+
+bool write_update_stream(const std::string &path, const Graph &g, const std::vector<std::vector<EdgeUpdate>> &batches) {
+    std::ofstream out(path);
+    if (!out.is_open()) { std::cerr << "Failed to open " << path << "\n"; return false; }
+    out << std::setprecision(10);
+    static const char *ops[] = {"set", "insert", "close"};
+    for (const auto &batch : batches) {
+        for (const auto &up : batch) {
+            out << ops[up.kind] << " " << g.to_external(up.u) << " " << g.to_external(up.v);
+            if (up.kind != EdgeUpdate::Close) out << " " << up.w;
+            out << "\n";
+        }
+        out << "commit\n";
+    }
+    return (bool)out;
+}
+
+GraphVersions::GraphVersions(Graph g): cur(std::make_shared<const Graph>(std::move(g))) {}
+
+GraphVersions::Published GraphVersions::apply(const std::vector<EdgeUpdate> &batch, int metric) {
+    std::lock_guard<std::mutex> lock(writer);
+    Published p;
+    auto t0 = std::chrono::steady_clock::now();
+    auto next = std::make_shared<Graph>(Graph::fork(cur));
+    auto t1 = std::chrono::steady_clock::now();
+    p.result = next->apply_updates(batch, metric);
+    auto t2 = std::chrono::steady_clock::now();
+    p.copy_ms = std::chrono::duration<double, std::milli>(t1 - t0).count();
+    p.apply_ms = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    if (!p.result.applied) { p.graph = cur; return p; }
+    if (p.result.decreased) bounds_hold = false;
+    p.graph = next;
+    std::atomic_store(&cur, std::shared_ptr<const Graph>(std::move(next)));
+    return p;
+}
@@ -0,0 +1,54 @@
+#ifndef GRAPH_UPDATES_H
+#define GRAPH_UPDATES_H
+
+#include "graph.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/* Update stream: text, one change per line, external node ids
+     set <u> <v> <weight>      new weight of u->v (and v->u on undirected graphs)
+     close <u> <v>             weight +inf until a later set
+     insert <u> <v> <weight>   new edge
+     commit                    ends a batch; lines after the last commit form a final batch
+   Blank lines and lines starting with '#' are ignored.
+*/
+// one set / close / insert line; false for anything else (including commit and comments)
+bool parse_update(const std::string &line, const Graph &g, EdgeUpdate &out);
+// batches in file order; malformed lines are reported on stderr and skipped
+bool load_update_stream(const std::string &path, const Graph &g, std::vector<std::vector<EdgeUpdate>> &batches);
+bool write_update_stream(const std::string &path, const Graph &g, const std::vector<std::vector<EdgeUpdate>> &batches);
+
+/* Copy-on-write versions of a graph that is searched while it is updated.
+   Readers take current() once per query and keep the shared_ptr while they
+   search; the graph behind it never changes. apply() forks the current
+   graph (Graph::fork: shared topology, copied weights), applies the batch
+   to the fork and publishes it atomically, so queries never wait for a
+   writer and see either none or all of a batch. Writers take turns; an
+   old version is freed with its last reader, except for the version
+   that owns the shared topology.
+*/
+class GraphVersions {
+public:
+    struct Published {
+        UpdateResult result;
+        std::shared_ptr<const Graph> graph;  // the version the batch produced
+        double copy_ms = 0, apply_ms = 0;
+    };
+
+    explicit GraphVersions(Graph g);
+    std::shared_ptr<const Graph> current() const { return std::atomic_load(&cur); }
+    Published apply(const std::vector<EdgeUpdate> &batch, int metric = 0);
+    // false once any published batch lowered a weight or inserted an edge since construction,
+    // i.e. lower bounds precomputed on the first version (landmarks) may no longer hold
+    bool lower_bounds_hold() const { return bounds_hold.load(); }
+
+private:
+    std::shared_ptr<const Graph> cur;
+    std::mutex writer;
+    std::atomic<bool> bounds_hold{true};
+};
+
+#endif // GRAPH_UPDATES_H
@@ -0,0 +1,77 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <cstddef>
+#include <chrono>
+
+/* Hot-path instrumentation for the search kernels.
+   Build with -DROUTE_INSTRUMENT to record the per-query SearchCounters
+   (Stats::counters); without it ROUTE_COUNT and PhaseClock compile to
+   nothing and the counters stay zero, so the kernels pay no overhead.
+   -DROUTE_TRACE additionally writes begin/end markers for every query to
+   the ftrace trace_marker file, where `perf record -e ftrace:print` or
+   trace-cmd show them next to the samples. Neither flag changes results.
+*/
+struct SearchCounters {
+    size_t relaxations = 0;      // edges scanned
+    size_t improvements = 0;     // relaxations that lowered a tentative distance
+    size_t stale_pops = 0;       // queue entries skipped as outdated or already settled
+    size_t heuristic_evals = 0;  // A* / ALT heuristic calls
+    long long setup_ns = 0;      // context reset and queue seeding
+    long long search_ns = 0;     // main loop
+    long long path_ns = 0;       // path reconstruction / shortcut unpacking
+
+    SearchCounters& operator+=(const SearchCounters &o) {
+        relaxations += o.relaxations; improvements += o.improvements;
+        stale_pops += o.stale_pops; heuristic_evals += o.heuristic_evals;
+        setup_ns += o.setup_ns; search_ns += o.search_ns; path_ns += o.path_ns;
+        return *this;
+    }
+};
+
+#ifdef ROUTE_INSTRUMENT
+constexpr bool instrumentation_enabled = true;
+#define ROUTE_COUNT(counter) (++(counter))
+#define ROUTE_COUNT_N(counter, n) ((counter) += (n))
+#else
+constexpr bool instrumentation_enabled = false;
+#define ROUTE_COUNT(counter) ((void)0)
+#define ROUTE_COUNT_N(counter, n) ((void)0)
+#endif
+
+// lap() returns the nanoseconds since construction or the previous lap (0 when not instrumented)
+class PhaseClock {
+public:
+#ifdef ROUTE_INSTRUMENT
+    PhaseClock() : last(std::chrono::steady_clock::now()) {}
+    long long lap() {
+        auto now = std::chrono::steady_clock::now();
+        long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(now - last).count();
+        last = now;
+        return ns;
+    }
+private:
+    std::chrono::steady_clock::time_point last;
+#else
+    long long lap() { return 0; }
+#endif
+};
+
+// writes one line to the trace_marker file; no-op when tracing is unavailable
+void trace_marker(const char *fmt, ...);
+
+// "<name> begin s t" on construction, "<name> end s t" on destruction
+class TraceScope {
+public:
+#ifdef ROUTE_TRACE
+    TraceScope(const char *name, int s, int t) : name(name), s(s), t(t) { trace_marker("route: %s begin %d %d", name, s, t); }
+    ~TraceScope() { trace_marker("route: %s end %d %d", name, s, t); }
+private:
+    const char *name;
+    int s, t;
+#else
+    TraceScope(const char *, int, int) {}
+#endif
+};
+
+#endif // INSTRUMENTATION_H
@@ -1,13 +1,20 @@
 #include "io.h"
+#include "isochrone.h"
+#include "buffered_writer.h"
+#include <algorithm>
 #include <fstream>
-#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <cmath>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
 bool write_geojson(const Graph &g, const std::vector<int> &path, const std::string &outpath) {
-    std::ofstream out(outpath);
+    BufferedWriter out(outpath);
     if (!out.is_open()) { std::cerr<<"Failed to open geojson file\n"; return false; }
     const auto &coords = g.get_coords();
-    out << std::fixed << std::setprecision(7);
+    out.fixed(7);
     out << "{ \"type\": \"FeatureCollection\", \"features\": [\n";
 
     // path line
@@ -37,8 +44,50 @@ bool write_geojson(const Graph &g, const std::vector<int> &path, const std::stri
       out << ",{ \"type\":\"Feature\", \"geometry\": { \"type\":\"Point\", \"coordinates\": [" << coords[id].second << ", " << coords[id].first << "] }, \"properties\": { \"marker-color\":\"" << color << "\", \"title\":\"" << title << "\" } }";
     }
     out << "] }\n";
-    out.close();
-    return true;
+    return out.close();
+}
+
+bool write_isochrone_geojson(const Graph &g, const std::vector<RangeResult> &ranges, const std::string &outpath, double cell_km) {
+    BufferedWriter out(outpath);
+    if (!out.is_open()) { std::cerr<<"Failed to open geojson file\n"; return false; }
+    const auto &coords = g.get_coords();
+    out.fixed(7);
+    out << "{ \"type\": \"FeatureCollection\", \"features\": [\n";
+    std::vector<size_t> order(ranges.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return ranges[a].budget > ranges[b].budget; });
+    // red for the largest budget to green for the smallest
+    static const char *colors[] = {"#d7191c", "#fdae61", "#ffffbf", "#a6d96a", "#1a9641"};
+    bool first = true;
+    for (size_t k = 0; k < order.size(); ++k) {
+        const RangeResult &r = ranges[order[k]];
+        if (r.nodes.empty()) continue;
+        const char *color = colors[order.size() > 1 ? k * 4 / (order.size() - 1) : 0];
+        out << (first ? "" : ",\n") << "{ \"type\":\"Feature\", \"geometry\": { \"type\":\"MultiPolygon\", \"coordinates\": [";
+        first = false;
+        auto polys = range_polygons(g, r, cell_km);
+        for (size_t p = 0; p < polys.size(); ++p) {
+            out << (p ? ", [" : "[");
+            for (size_t q = 0; q < polys[p].size(); ++q) {
+                out << (q ? ", [" : "[");
+                for (size_t i = 0; i < polys[p][q].size(); ++i)
+                    out << (i ? ", [" : "[") << polys[p][q][i].second << ", " << polys[p][q][i].first << "]";
+                out << "]";
+            }
+            out << "]";
+        }
+        out << "] }, \"properties\": { \"budget\": ";
+        out.fixed(3) << r.budget;
+        out.fixed(7) << ", \"nodes\": " << r.nodes.size() << ", \"stroke\": \"" << color << "\", \"stroke-width\": 2, \"fill\": \""
+            << color << "\", \"fill-opacity\": 0.35 } }";
+    }
+    if (!ranges.empty() && ranges[0].source >= 0) {
+        const auto &c = coords[ranges[0].source];
+        out << (first ? "" : ",\n") << "{ \"type\":\"Feature\", \"geometry\": { \"type\":\"Point\", \"coordinates\": ["
+            << c.second << ", " << c.first << "] }, \"properties\": { \"marker-color\":\"#0000FF\", \"title\":\"source\" } }";
+    }
+    out << "\n] }\n";
+    return out.close();
 }
 
 bool write_leaflet_html(const std::string &geojson_file, const std::string &html_out) {
@@ -57,17 +106,15 @@ bool write_leaflet_html(const std::string &geojson_file, const std::string &html
 <div id="map"></div>
 <script src="https://unpkg.com/leaflet@1.9.4/dist/leaflet.js"></script>
 <script>
-fetch('route.geojson').then(r=>r.json()).then(data=>{
+fetch(')" << geojson_file << R"(').then(r=>r.json()).then(data=>{
   var map = L.map('map');
-  var coords = data.features[0].geometry.coordinates;
-  var first = coords[0];
-  map.setView([first[1], first[0]], 12);
   L.tileLayer('https://{s}.tile.openstreetmap.org/{z}/{x}/{y}.png', {
     attribution: '© OpenStreetMap contributors'
   }).addTo(map);
-    L.geoJSON(data, {
+    var layer = L.geoJSON(data, {
       style: function(feature){
-        return {color: feature.properties.stroke || '#00FF00', weight: feature.properties["stroke-width"]||3};
+        return {color: feature.properties.stroke || '#00FF00', weight: feature.properties["stroke-width"]||3,
+                fillColor: feature.properties.fill, fillOpacity: feature.properties["fill-opacity"]};
       },
       pointToLayer: function(feature, latlng){
         return L.circleMarker(latlng, {
@@ -78,6 +125,10 @@ fetch('route.geojson').then(r=>r.json()).then(data=>{
         });
       }
     }).addTo(map);
+  // routes open on their first point, polygons (isochrones) fit the view
+  var geom = data.features[0].geometry;
+  if (geom.type == 'LineString' && geom.coordinates.length) map.setView([geom.coordinates[0][1], geom.coordinates[0][0]], 12);
+  else map.fitBounds(layer.getBounds());
 });
 </script>
 </body>
@@ -88,13 +139,226 @@ fetch('route.geojson').then(r=>r.json()).then(data=>{
 
 bool write_metrics_csv(const std::string &out_csv,
                        const std::vector<std::pair<std::string, Stats>> &rows) {
-    std::ofstream out(out_csv);
+    BufferedWriter out(out_csv);
     if (!out.is_open()) { std::cerr<<"Failed to open metrics csv\n"; return false; }
-    out << "label,distance,nodes_expanded,millis,path_len\n";
+    out << "label,distance,nodes_expanded,millis,path_len,pq_pushes,relaxations,improvements,stale_pops,"
+           "heuristic_evals,setup_ns,search_ns,path_ns\n";
     for (const auto &p : rows) {
         const Stats &s = p.second;
-        out << p.first << "," << s.distance << "," << s.nodes_expanded << "," << s.millis << "," << s.path.size() << "\n";
+        const SearchCounters &c = s.counters;
+        out << p.first << "," << s.distance << "," << s.nodes_expanded << "," << s.millis << "," << s.path.size()
+            << "," << s.pq_pushes << "," << c.relaxations << "," << c.improvements << "," << c.stale_pops
+            << "," << c.heuristic_evals << "," << c.setup_ns << "," << c.search_ns << "," << c.path_ns << "\n";
     }
-    out.close();
+    return out.close();
+}
+
+static void counters_json(BufferedWriter &out, const SearchCounters &c) {
+    out << "{\"relaxations\":" << c.relaxations << ",\"improvements\":" << c.improvements
+        << ",\"stale_pops\":" << c.stale_pops << ",\"heuristic_evals\":" << c.heuristic_evals
+        << ",\"setup_ns\":" << c.setup_ns << ",\"search_ns\":" << c.search_ns << ",\"path_ns\":" << c.path_ns << "}";
+}
+
+bool write_metrics_json(const std::string &out_json,
+                        const std::vector<std::pair<std::string, Stats>> &rows) {
+    BufferedWriter out(out_json);
+    if (!out.is_open()) { std::cerr<<"Failed to open metrics json\n"; return false; }
+    out.general(10);
+    out << "[\n";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const Stats &s = rows[i].second;
+        out << "  {\"label\":\"" << rows[i].first << "\",\"distance\":";
+        if (std::isfinite(s.distance)) out << s.distance;
+        else out << "null";
+        out << ",\"nodes_expanded\":" << s.nodes_expanded << ",\"micros\":" << s.millis
+            << ",\"path_len\":" << s.path.size() << ",\"pq_pushes\":" << s.pq_pushes
+            << ",\"pq_max_size\":" << s.pq_max_size << ",\"instrumented\":" << (instrumentation_enabled ? "true" : "false")
+            << ",\"counters\":";
+        counters_json(out, s.counters);
+        out << "}" << (i + 1 < rows.size() ? "," : "") << "\n";
+    }
+    out << "]\n";
+    return out.close();
+}
+
+bool write_graph_csv(const Graph &g, const std::string &nodes_csv, const std::string &edges_csv, bool undirected) {
+    BufferedWriter nodes(nodes_csv);
+    if (!nodes.is_open()) { std::cerr<<"Failed to open nodes csv\n"; return false; }
+    const auto coords = g.get_coords();
+    const auto names = g.get_names();
+    nodes.general(10);
+    nodes << "node_id,lat,lon,name\n";
+    for (int ext = 0; ext < g.num_nodes(); ++ext) {
+        int u = g.to_internal(ext);
+        nodes << ext << "," << coords[u].first << "," << coords[u].second << "," << names[u] << "\n";
+    }
+    if (!nodes.close()) return false;
+
+    BufferedWriter edges(edges_csv);
+    if (!edges.is_open()) { std::cerr<<"Failed to open edges csv\n"; return false; }
+    edges.general(10);
+    edges << "src_id,dst_id";
+    for (int k = 0; k < g.num_metrics(); ++k) edges << "," << g.metric_name(k);
+    edges << "\n";
+    const bool pairs = undirected && !g.is_directed();
+    std::vector<EdgeRange::iterator> it;
+    for (int u = 0; u < g.num_nodes(); ++u) {
+        int eu = g.to_external(u);
+        it.clear();
+        for (int k = 0; k < g.num_metrics(); ++k) it.push_back(g.neighbors(u, k).begin());
+        for (int i = 0; i < g.degree(u); ++i) {
+            int ev = g.to_external((*it[0]).to);
+            if (!pairs || ev >= eu) {
+                edges << eu << "," << ev;
+                for (auto &m : it) edges << "," << (*m).w;
+                edges << "\n";
+            }
+            for (auto &m : it) ++m;
+        }
+    }
+    return edges.close();
+}
+
+bool write_profiles_csv(const Graph &g, const std::vector<ProfileRow> &rows, const std::string &out_csv) {
+    BufferedWriter out(out_csv);
+    if (!out.is_open()) { std::cerr<<"Failed to open profiles csv\n"; return false; }
+    out.general(10);
+    out << "src_id,dst_id,time,travel_time\n";
+    for (const auto &r : rows) out << g.to_external(r.u) << "," << g.to_external(r.v) << "," << r.time << "," << r.travel << "\n";
+    return out.close();
+}
+
+bool write_matrix_csv(const std::string &out_csv, const DistanceMatrix &m) {
+    BufferedWriter out(out_csv);
+    if (!out.is_open()) { std::cerr<<"Failed to open matrix csv\n"; return false; }
+    out.general(10);
+    out << "source";
+    for (int t : m.targets) out << "," << t;
+    out << "\n";
+    for (size_t i = 0; i < m.sources.size(); ++i) {
+        out << m.sources[i];
+        for (size_t j = 0; j < m.targets.size(); ++j) {
+            double d = m.at(i, j);
+            out << ",";
+            if (d == std::numeric_limits<double>::infinity()) out << "inf";
+            else out << d;
+        }
+        out << "\n";
+    }
+    return out.close();
+}
+
+bool write_histograms_csv(const std::string &out_csv,
+                          const std::vector<std::pair<std::string, const LatencyHistogram*>> &hists) {
+    BufferedWriter out(out_csv);
+    if (!out.is_open()) { std::cerr<<"Failed to open histogram csv\n"; return false; }
+    out << "label,low_ns,high_ns,count\n";
+    for (const auto &h : hists)
+        for (const auto &b : h.second->buckets())
+            out << h.first << "," << b.low << "," << b.high << "," << b.count << "\n";
+    return out.close();
+}
+
+std::vector<size_t> simplify_polyline(const std::vector<std::pair<double,double>> &points, double tolerance_km) {
+    const size_t n = points.size();
+    std::vector<size_t> kept;
+    if (n <= 2 || !(tolerance_km > 0)) {
+        for (size_t i = 0; i < n; ++i) kept.push_back(i);
+        return kept;
+    }
+    const double ky = 110.574, kx = std::max(1e-6, 111.320 * std::cos(points[0].first * M_PI / 180.0));
+    std::vector<std::pair<double,double>> xy(n);
+    for (size_t i = 0; i < n; ++i) xy[i] = {(points[i].second - points[0].second) * kx, (points[i].first - points[0].first) * ky};
+    // squared distance from p to the segment a-b
+    auto dist2 = [&](size_t p, size_t a, size_t b) {
+        double dx = xy[b].first - xy[a].first, dy = xy[b].second - xy[a].second;
+        double px = xy[p].first - xy[a].first, py = xy[p].second - xy[a].second;
+        double len2 = dx * dx + dy * dy;
+        double t = len2 > 0 ? std::min(1.0, std::max(0.0, (px * dx + py * dy) / len2)) : 0.0;
+        double ex = px - t * dx, ey = py - t * dy;
+        return ex * ex + ey * ey;
+    };
+    std::vector<char> keep(n, 0);
+    keep[0] = keep[n-1] = 1;
+    std::vector<std::pair<size_t,size_t>> spans = {{0, n - 1}};
+    while (!spans.empty()) {
+        auto [a, b] = spans.back();
+        spans.pop_back();
+        double worst = -1;
+        size_t at = a;
+        for (size_t i = a + 1; i < b; ++i) {
+            double d = dist2(i, a, b);
+            if (d > worst) { worst = d; at = i; }
+        }
+        if (worst <= tolerance_km * tolerance_km) continue;
+        keep[at] = 1;
+        spans.push_back({a, at});
+        spans.push_back({at, b});
+    }
+    for (size_t i = 0; i < n; ++i) if (keep[i]) kept.push_back(i);
+    return kept;
+}
+
+GeoJsonRouteStream::GeoJsonRouteStream(const std::string &path, double tolerance_km): out(path), tolerance(tolerance_km) {
+    if (!out.is_open()) { std::cerr<<"Failed to open geojson file\n"; return; }
+    out << "{ \"type\": \"FeatureCollection\", \"features\": [\n";
+}
+
+bool GeoJsonRouteStream::add(const Graph &g, const std::vector<int> &path, const std::string &label, double distance) {
+    if (path.empty()) return false;
+    // formatted per thread, so the lock only covers the append
+    thread_local BufferedWriter feature;
+    thread_local std::vector<std::pair<double,double>> line;
+    const auto &coords = g.get_coords();
+    line.clear();
+    for (int v : path) line.push_back(coords[v]);
+    const std::vector<size_t> kept = simplify_polyline(line, tolerance);
+    feature.clear();
+    feature.fixed(7) << "{ \"type\":\"Feature\", \"geometry\": { \"type\":\"LineString\", \"coordinates\": [";
+    for (size_t i = 0; i < kept.size(); ++i)
+        feature << (i ? ", [" : "[") << line[kept[i]].second << ", " << line[kept[i]].first << "]";
+    feature << "] }, \"properties\": { \"label\": \"" << label << "\", \"distance\": ";
+    if (std::isfinite(distance)) feature.general(10) << distance;
+    else feature << "null";
+    feature << ", \"nodes\": " << path.size() << ", \"source\": " << g.to_external(path.front())
+            << ", \"target\": " << g.to_external(path.back()) << " } }";
+    std::lock_guard<std::mutex> lock(mu);
+    if (!out.is_open()) return false;
+    if (count++) out << ",\n";
+    out << feature.view();
+    points += kept.size();
+    nodes += path.size();
     return true;
 }
+
+bool GeoJsonRouteStream::close() {
+    std::lock_guard<std::mutex> lock(mu);
+    if (!out.is_open()) return false;
+    out << "\n] }\n";
+    return out.close();
+}
+
+std::string stats_json(const Stats &st, const Graph &g, bool with_path) {
+    BufferedWriter out;
+    out.general(10);
+    out << "{\"distance\":";
+    if (std::isfinite(st.distance)) out << st.distance;
+    else out << "null";
+    out << ",\"nodes_expanded\":" << st.nodes_expanded << ",\"micros\":" << st.millis
+        << ",\"pq_pushes\":" << st.pq_pushes << ",\"pq_max_size\":" << st.pq_max_size
+        << ",\"path_len\":" << st.path.size();
+    if (instrumentation_enabled) {
+        out << ",\"counters\":";
+        counters_json(out, st.counters);
+    }
+    if (with_path) {
+        out << ",\"path\":[";
+        for (size_t i = 0; i < st.path.size(); ++i) {
+            if (i) out << ",";
+            out << g.to_external(st.path[i]);
+        }
+        out << "]";
+    }
+    out << "}";
+    return out.str();
+}
@@ -3,13 +3,72 @@
 
 #include "graph.h"
 #include "planner.h"
+#include "latency_histogram.h"
+#include "buffered_writer.h"
+#include <mutex>
 #include <string>
 #include <vector>
 #include <utility>
 
+// Writers go through BufferedWriter; doubles keep the ostream formatting they always had.
 bool write_geojson(const Graph &g, const std::vector<int> &path, const std::string &outpath);
+// range outlines (range_polygons) as a FeatureCollection: one MultiPolygon per range, largest budget
+// first so smaller ranges draw on top, each with its budget and node count, then the source as a Point
+bool write_isochrone_geojson(const Graph &g, const std::vector<RangeResult> &ranges, const std::string &outpath, double cell_km = 0.0);
+// Leaflet page showing geojson_file (a path relative to the page)
 bool write_leaflet_html(const std::string &geojson_file, const std::string &html_out);
+// one row per label; the counter columns are zero unless built with ROUTE_INSTRUMENT
 bool write_metrics_csv(const std::string &out_csv,
                        const std::vector<std::pair<std::string, Stats>> &rows);
+// same rows as a JSON array of objects, counters nested under "counters"
+bool write_metrics_json(const std::string &out_json,
+                        const std::vector<std::pair<std::string, Stats>> &rows);
+// nodes.csv + edges.csv in the loader format, external ids, one weight column per metric;
+// undirected writes each u-v pair once (u < v), directed graphs always write every edge
+bool write_graph_csv(const Graph &g, const std::string &nodes_csv, const std::string &edges_csv, bool undirected = true);
+// travel-time profile rows in the TravelTimeProfiles::load_csv format (external ids)
+bool write_profiles_csv(const Graph &g, const std::vector<ProfileRow> &rows, const std::string &out_csv);
+// header row of target ids, then one row per source: id followed by distances ("inf" when unreachable)
+bool write_matrix_csv(const std::string &out_csv, const DistanceMatrix &m);
+// labelled latency histograms in one CSV: label,low_ns,high_ns,count (non-empty buckets only)
+bool write_histograms_csv(const std::string &out_csv,
+                          const std::vector<std::pair<std::string, const LatencyHistogram*>> &hists);
+// Douglas-Peucker on a (lat, lon) polyline: indices of the points to keep, in order, so that
+// no dropped point is farther than tolerance_km from the kept line (first and last always
+// kept; tolerance_km <= 0 keeps everything). Distances use a flat projection around the
+// first point, which is accurate for anything shorter than a few hundred km.
+std::vector<size_t> simplify_polyline(const std::vector<std::pair<double,double>> &points, double tolerance_km);
+
+/* FeatureCollection of routes written while they are computed. add()
+   formats one LineString feature (path simplified to tolerance_km when
+   > 0; properties label, distance, nodes and the external source / target
+   ids) outside the lock, then appends it, so workers can add routes as
+   they finish; features appear in the order add() was called. Empty paths
+   are skipped. close() (or the destructor) ends the collection.
+*/
+class GeoJsonRouteStream {
+public:
+    explicit GeoJsonRouteStream(const std::string &path, double tolerance_km = 0.0);
+    ~GeoJsonRouteStream() { close(); }
+    bool is_open() const { return out.is_open(); }
+    bool add(const Graph &g, const std::vector<int> &path, const std::string &label, double distance);
+    // false when a write failed
+    bool close();
+
+    size_t features() const { return count; }
+    size_t vertices() const { return points; }   // coordinates written, after simplification
+    size_t path_nodes() const { return nodes; }  // path nodes given to add()
+    size_t bytes() const { return out.bytes(); }
+
+private:
+    std::mutex mu;
+    BufferedWriter out;
+    double tolerance;
+    size_t count = 0, points = 0, nodes = 0;
+};
+
+// one-line JSON object for a query result; path ids are external (Graph::to_external), distance null when unreachable;
+// instrumented builds add the SearchCounters as "counters"
+std::string stats_json(const Stats &st, const Graph &g, bool with_path = true);
 
 #endif // IO_H
@@ -0,0 +1,183 @@
+#include "isochrone.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+namespace {
+
+const double KM_PER_DEG_LAT = 110.574;
+const double KM_PER_DEG_LON = 111.320;  // at the equator
+const long long MAX_CELLS = 1 << 22;
+
+struct Segment { double x0, y0, x1, y1; };  // km east / north of the source
+
+// side of a covered cell that faces an uncovered one, directed with the covered cell on its left
+struct BoundaryEdge {
+    long long from;
+    int x, y, dx, dy;
+};
+
+// > 0 for counter-clockwise rings
+double signed_area(const std::vector<std::pair<int,int>> &ring) {
+    double a = 0;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++)
+        a += (double)ring[j].first * ring[i].second - (double)ring[i].first * ring[j].second;
+    return a / 2;
+}
+
+bool inside(const std::vector<std::pair<int,int>> &ring, double x, double y) {
+    bool in = false;
+    for (size_t i = 0, j = ring.size() - 1; i < ring.size(); j = i++) {
+        double xi = ring[i].first, yi = ring[i].second, xj = ring[j].first, yj = ring[j].second;
+        if ((yi > y) != (yj > y) && x < (xj - xi) * (y - yi) / (yj - yi) + xi) in = !in;
+    }
+    return in;
+}
+
+} // namespace
+
+std::vector<Polygon> range_polygons(const Graph &g, const RangeResult &r, double cell_km) {
+    if (r.nodes.empty()) return {};
+    const auto coords = g.get_coords();
+    const double lat0 = coords[r.source].first, lon0 = coords[r.source].second;
+    const double kx = std::max(1e-6, KM_PER_DEG_LON * std::cos(lat0 * M_PI / 180.0)), ky = KM_PER_DEG_LAT;
+    auto point = [&](int v) { return std::make_pair((coords[v].second - lon0) * kx, (coords[v].first - lat0) * ky); };
+
+    // the reached network: nodes, edges between reached nodes, frontier edges up to their fraction.
+    // range_search lists the frontier in node and edge order, so every other open edge of a
+    // reached node ends in the range
+    std::vector<Segment> segs;
+    size_t f = 0;
+    for (int u : r.nodes) {
+        auto pu = point(u);
+        segs.push_back({pu.first, pu.second, pu.first, pu.second});
+        for (const auto &e : g.neighbors(u, r.metric)) {
+            if (f < r.frontier.size() && r.frontier[f].u == u && r.frontier[f].v == e.to) {
+                const double t = r.frontier[f++].fraction;
+                auto pv = point(e.to);
+                segs.push_back({pu.first, pu.second, pu.first + t * (pv.first - pu.first), pu.second + t * (pv.second - pu.second)});
+            } else if (std::isfinite(e.w) && e.to != u && (g.is_directed() || e.to > u)) {
+                auto pv = point(e.to);
+                segs.push_back({pu.first, pu.second, pv.first, pv.second});
+            }
+        }
+    }
+    double xmin = 0, xmax = 0, ymin = 0, ymax = 0, total = 0;
+    size_t counted = 0;
+    for (const auto &s : segs) {
+        xmin = std::min({xmin, s.x0, s.x1}); xmax = std::max({xmax, s.x0, s.x1});
+        ymin = std::min({ymin, s.y0, s.y1}); ymax = std::max({ymax, s.y0, s.y1});
+        double len = std::hypot(s.x1 - s.x0, s.y1 - s.y0);
+        if (len > 0) { total += len; counted++; }
+    }
+    double cell = cell_km > 0 ? cell_km : counted ? total / counted : 0.1;
+    // two cells of padding on every side keep the closing and the tracing off the border
+    int W, H;
+    while (true) {
+        W = (int)std::min(1e9, (xmax - xmin) / cell) + 5;
+        H = (int)std::min(1e9, (ymax - ymin) / cell) + 5;
+        if ((long long)W * H <= MAX_CELLS) break;
+        cell *= 1.5;
+    }
+    const double gx0 = xmin - 2 * cell, gy0 = ymin - 2 * cell;
+
+    std::vector<char> mask((size_t)W * H, 0);
+    for (const auto &s : segs) {
+        int steps = (int)std::ceil(std::hypot(s.x1 - s.x0, s.y1 - s.y0) / (cell / 2));
+        for (int k = 0; k <= steps; ++k) {
+            double t = steps ? (double)k / steps : 0.0;
+            int cx = (int)((s.x0 + t * (s.x1 - s.x0) - gx0) / cell), cy = (int)((s.y0 + t * (s.y1 - s.y0) - gy0) / cell);
+            mask[(size_t)cy * W + cx] = 1;
+        }
+    }
+    // closing (3x3 dilation, then erosion) fills the one-cell gaps between nearby roads
+    auto morph = [&](const std::vector<char> &in, bool dilate) {
+        std::vector<char> out((size_t)W * H, 0);
+        for (int y = 1; y + 1 < H; ++y) {
+            for (int x = 1; x + 1 < W; ++x) {
+                bool any = false, all = true;
+                for (int dy = -1; dy <= 1; ++dy)
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        bool c = in[(size_t)(y + dy) * W + x + dx];
+                        any |= c;
+                        all &= c;
+                    }
+                out[(size_t)y * W + x] = dilate ? any : all;
+            }
+        }
+        return out;
+    };
+    mask = morph(morph(mask, true), false);
+
+    // boundary sides; at a vertex shared by two diagonal cells the walk turns left, keeping the cells apart
+    auto covered = [&](int x, int y) { return mask[(size_t)y * W + x] != 0; };
+    auto key = [&](int x, int y) { return (long long)y * (W + 1) + x; };
+    std::vector<BoundaryEdge> edges;
+    for (int y = 1; y + 1 < H; ++y) {
+        for (int x = 1; x + 1 < W; ++x) {
+            if (!covered(x, y)) continue;
+            if (!covered(x, y - 1)) edges.push_back({key(x, y), x, y, 1, 0});
+            if (!covered(x + 1, y)) edges.push_back({key(x + 1, y), x + 1, y, 0, 1});
+            if (!covered(x, y + 1)) edges.push_back({key(x + 1, y + 1), x + 1, y + 1, -1, 0});
+            if (!covered(x - 1, y)) edges.push_back({key(x, y + 1), x, y + 1, 0, -1});
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [](const BoundaryEdge &a, const BoundaryEdge &b) { return a.from < b.from; });
+    std::vector<char> used(edges.size(), 0);
+    auto next_edge = [&](const BoundaryEdge &e) {
+        long long to = key(e.x + e.dx, e.y + e.dy);
+        size_t i = std::lower_bound(edges.begin(), edges.end(), to, [](const BoundaryEdge &a, long long k) { return a.from < k; }) - edges.begin();
+        if (i + 1 < edges.size() && edges[i + 1].from == to && edges[i + 1].dx == -e.dy && edges[i + 1].dy == e.dx) return i + 1;
+        return i;
+    };
+
+    std::vector<std::vector<std::pair<int,int>>> outers, holes;
+    for (size_t start = 0; start < edges.size(); ++start) {
+        if (used[start]) continue;
+        std::vector<std::pair<int,int>> ring;
+        size_t i = start;
+        do {
+            used[i] = 1;
+            size_t j = next_edge(edges[i]);
+            // keep corners only
+            if (edges[j].dx != edges[i].dx || edges[j].dy != edges[i].dy) ring.push_back({edges[j].x, edges[j].y});
+            i = j;
+        } while (i != start);
+        if (ring.size() < 3) continue;
+        (signed_area(ring) > 0 ? outers : holes).push_back(std::move(ring));
+    }
+
+    std::vector<Polygon> polys(outers.size());
+    std::vector<double> areas(outers.size());
+    auto to_ring = [&](const std::vector<std::pair<int,int>> &pts) {
+        Ring ring;
+        for (const auto &p : pts) ring.push_back({lat0 + (gy0 + p.second * cell) / ky, lon0 + (gx0 + p.first * cell) / kx});
+        ring.push_back(ring.front());
+        return ring;
+    };
+    for (size_t k = 0; k < outers.size(); ++k) {
+        polys[k].push_back(to_ring(outers[k]));
+        areas[k] = signed_area(outers[k]);
+    }
+    // a hole belongs to the smallest outer ring around the covered cell on its left
+    for (const auto &h : holes) {
+        int dx = h[1].first - h[0].first, dy = h[1].second - h[0].second;
+        dx = (dx > 0) - (dx < 0);
+        dy = (dy > 0) - (dy < 0);
+        double x = h[0].first + 0.5 * dx - 0.5 * dy, y = h[0].second + 0.5 * dy + 0.5 * dx;
+        int best = -1;
+        for (size_t k = 0; k < outers.size(); ++k)
+            if ((best < 0 || areas[k] < areas[best]) && inside(outers[k], x, y)) best = (int)k;
+        if (best >= 0) polys[best].push_back(to_ring(h));
+    }
+    std::vector<size_t> order(polys.size());
+    for (size_t k = 0; k < order.size(); ++k) order[k] = k;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return areas[a] > areas[b]; });
+    std::vector<Polygon> sorted;
+    for (size_t k : order) sorted.push_back(std::move(polys[k]));
+    return sorted;
+}
@@ -0,0 +1,26 @@
+#ifndef ISOCHRONE_H
+#define ISOCHRONE_H
+
+#include "graph.h"
+#include "planner.h"
+#include <utility>
+#include <vector>
+
+// closed ring of (lat, lon) points, first == last
+using Ring = std::vector<std::pair<double,double>>;
+// rings[0] is the outer ring (counter-clockwise), the rest are its holes (clockwise)
+using Polygon = std::vector<Ring>;
+
+/* Outline of a range as polygons. The reached part of the network (edges
+   between reached nodes, and frontier edges up to their fraction) is drawn
+   onto a grid of cell_km squares around the source; gaps of one cell
+   between roads are closed, and the boundary of the covered cells is traced
+   into rings. The result follows the roads instead of a convex hull:
+   unreachable pockets become holes and disconnected parts separate
+   polygons. cell_km <= 0 picks the mean length of the drawn segments; the
+   cell grows as needed to keep the grid under ~4M cells. Vertices lie on
+   the grid, with collinear runs merged.
+*/
+std::vector<Polygon> range_polygons(const Graph &g, const RangeResult &r, double cell_km = 0.0);
+
+#endif // ISOCHRONE_H
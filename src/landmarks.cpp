@@ -0,0 +1,226 @@
+#include "landmarks.h"
+#include "parallel.h"
+#include <queue>
+#include <random>
+#include <algorithm>
+#include <functional>
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+namespace {
+
+const double INF = std::numeric_limits<double>::infinity();
+// ALT1 (no metric) and ALT2 (metric index) carry no fingerprint and are no longer accepted
+const char LANDMARK_MAGIC[4] = {'A','L','T','3'};
+
+// FNV-1a over the external ids, edge targets and weights of one metric in internal order:
+// differs after a reorder, a directed load or any change to routes.csv
+uint64_t graph_fingerprint(const Graph &g, int metric) {
+    uint64_t h = 1469598103934665603ULL;
+    auto add = [&h](uint64_t w) { h = (h ^ w) * 1099511628211ULL; };
+    add(g.num_nodes());
+    add(g.num_edges());
+    add(g.is_directed());
+    for (int u = 0; u < g.num_nodes(); ++u) {
+        add((uint64_t)g.to_external(u));
+        for (const auto &e : g.neighbors(u, metric)) {
+            uint64_t bits;
+            double w = e.w;
+            std::memcpy(&bits, &w, sizeof(bits));
+            add((uint64_t)g.to_external(e.to));
+            add(bits);
+        }
+    }
+    return h;
+}
+
+// full single-source Dijkstra on one metric, over the reversed graph when backward; parent is optional
+void sssp(const Graph &g, int s, int metric, bool backward, std::vector<double> &dist, std::vector<int> *parent = nullptr) {
+    const int n = g.num_nodes();
+    dist.assign(n, INF);
+    if (parent) parent->assign(n, -1);
+    using PQ = std::pair<double,int>;
+    std::priority_queue<PQ, std::vector<PQ>, std::greater<PQ>> pq;
+    dist[s] = 0.0;
+    pq.push({0.0, s});
+    while (!pq.empty()) {
+        auto [d,u] = pq.top(); pq.pop();
+        if (d != dist[u]) continue;
+        for (const auto &e : backward ? g.in_neighbors(u, metric) : g.neighbors(u, metric)) {
+            if (d + e.w < dist[e.to]) {
+                dist[e.to] = d + e.w;
+                if (parent) (*parent)[e.to] = u;
+                pq.push({dist[e.to], e.to});
+            }
+        }
+    }
+}
+
+// farthest: next landmark maximizes the distance to the closest chosen one
+int pick_farthest(const std::vector<std::vector<double>> &rows, int n, std::mt19937 &rng) {
+    if (rows.empty()) return std::uniform_int_distribution<int>(0, n-1)(rng);
+    int best = -1;
+    double best_d = -1.0;
+    for (int v = 0; v < n; ++v) {
+        double m = INF;
+        for (const auto &r : rows) m = std::min(m, r[v]);
+        if (m != INF && m > best_d) { best_d = m; best = v; }
+    }
+    return best;
+}
+
+/* avoid (Goldberg & Werneck): grow a shortest-path tree from a random root,
+   weight each node by how badly the current landmarks bound d(root, v),
+   sum weights over subtrees that contain no landmark yet and walk down the
+   heaviest subtree to a leaf.
+*/
+int pick_avoid(const Graph &g, int metric, const std::vector<std::vector<double>> &rows,
+               const std::vector<char> &is_landmark, std::mt19937 &rng) {
+    const int n = g.num_nodes();
+    int root = std::uniform_int_distribution<int>(0, n-1)(rng);
+    std::vector<double> dist;
+    std::vector<int> parent;
+    sssp(g, root, metric, false, dist, &parent);
+
+    std::vector<int> order;
+    for (int v = 0; v < n; ++v) if (dist[v] < INF) order.push_back(v);
+    std::sort(order.begin(), order.end(), [&](int a, int b){ return dist[a] > dist[b]; });
+
+    std::vector<double> size(n, 0.0);
+    std::vector<char> covered(n, 0);
+    for (int v : order) {
+        double lb = 0.0;
+        for (const auto &r : rows)
+            if (r[v] != INF && r[root] != INF) lb = std::max(lb, r[v] - r[root]);
+        size[v] += dist[v] - lb;
+        if (is_landmark[v]) covered[v] = 1;
+        if (covered[v]) size[v] = 0.0;
+        int p = parent[v];
+        if (p >= 0) {
+            size[p] += size[v];
+            if (covered[v]) covered[p] = 1;
+        }
+    }
+
+    std::vector<std::vector<int>> children(n);
+    for (int v : order) if (parent[v] >= 0) children[parent[v]].push_back(v);
+    int cur = root;
+    while (true) {
+        int next = -1;
+        for (int c : children[cur]) if (size[c] > 0.0 && (next < 0 || size[c] > size[next])) next = c;
+        if (next < 0) break;
+        cur = next;
+    }
+    return is_landmark[cur] ? -1 : cur;
+}
+
+} // namespace
+
+void Landmarks::build(const Graph &g, int num_landmarks, LandmarkSelection sel, int threads, unsigned seed, int metric) {
+    n = g.num_nodes();
+    k = 0;
+    metric_ = metric;
+    fingerprint_ = graph_fingerprint(g, metric);
+    landmark_ids.clear();
+    from.clear(); to.clear();
+    if (n == 0 || num_landmarks <= 0) return;
+    if (threads <= 0) threads = default_threads();
+
+    // selection is inherently sequential: each pick depends on the previous rows
+    std::mt19937 rng(seed);
+    std::vector<std::vector<double>> rows;
+    std::vector<char> is_landmark(n, 0);
+    for (int i = 0; i < num_landmarks && i < n; ++i) {
+        int l = -1;
+        if (sel == LandmarkSelection::Avoid && !rows.empty()) l = pick_avoid(g, metric, rows, is_landmark, rng);
+        if (l < 0) l = pick_farthest(rows, n, rng);
+        if (l < 0 || is_landmark[l]) break;
+        is_landmark[l] = 1;
+        landmark_ids.push_back(l);
+        rows.emplace_back();
+        sssp(g, l, metric, false, rows.back());
+    }
+    k = (int)landmark_ids.size();
+
+    // forward rows come from selection; the backward (to-landmark) rows are
+    // independent Dijkstras on the reversed graph, run in parallel
+    std::vector<std::vector<double>> to_rows(k);
+    parallel_for(k, threads, [&](int i) { sssp(g, landmark_ids[i], metric, true, to_rows[i]); });
+
+    from.assign((size_t)n*k, INF);
+    to.assign((size_t)n*k, INF);
+    for (int i = 0; i < k; ++i) {
+        for (int u = 0; u < n; ++u) {
+            from[(size_t)u*k+i] = rows[i][u];
+            to[(size_t)u*k+i] = to_rows[i][u];
+        }
+    }
+}
+
+bool Landmarks::save(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) { std::cerr << "Failed to open landmark file: " << path << "\n"; return false; }
+    out.write(LANDMARK_MAGIC, 4);
+    out.write(reinterpret_cast<const char*>(&n), sizeof(n));
+    out.write(reinterpret_cast<const char*>(&k), sizeof(k));
+    out.write(reinterpret_cast<const char*>(&metric_), sizeof(metric_));
+    out.write(reinterpret_cast<const char*>(&fingerprint_), sizeof(fingerprint_));
+    out.write(reinterpret_cast<const char*>(landmark_ids.data()), sizeof(int)*k);
+    out.write(reinterpret_cast<const char*>(from.data()), sizeof(double)*from.size());
+    out.write(reinterpret_cast<const char*>(to.data()), sizeof(double)*to.size());
+    return (bool)out;
+}
+
+bool Landmarks::load(const std::string &path, const Graph &g, int metric) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in.is_open()) return false;
+    char magic[4];
+    int file_n = 0, file_k = 0, file_metric = 0;
+    uint64_t file_fingerprint = 0;
+    if (in.read(magic, 4) && std::memcmp(magic, "ALT", 3) == 0 && std::memcmp(magic, LANDMARK_MAGIC, 4) != 0) {
+        std::cerr << "Landmark file " << path << " predates graph fingerprints, rebuilding\n";
+        return false;
+    }
+    in.read(reinterpret_cast<char*>(&file_n), sizeof(file_n));
+    in.read(reinterpret_cast<char*>(&file_k), sizeof(file_k));
+    in.read(reinterpret_cast<char*>(&file_metric), sizeof(file_metric));
+    in.read(reinterpret_cast<char*>(&file_fingerprint), sizeof(file_fingerprint));
+    if (!in || std::memcmp(magic, LANDMARK_MAGIC, 4) != 0 || file_n < 0 || file_k < 0 || file_k > file_n) {
+        std::cerr << "Invalid landmark file: " << path << "\n";
+        return false;
+    }
+    if (file_n != g.num_nodes()) {
+        std::cerr << "Landmark file " << path << " is for " << file_n << " nodes, graph has " << g.num_nodes() << "\n";
+        return false;
+    }
+    if (file_metric != metric) {
+        std::cerr << "Landmark file " << path << " is for metric " << file_metric << ", wanted " << metric << "\n";
+        return false;
+    }
+    const uint64_t fingerprint = graph_fingerprint(g, metric);
+    if (file_fingerprint != fingerprint) {
+        std::cerr << "Landmark file " << path << " was built for another graph or node numbering\n";
+        return false;
+    }
+    // the payload size follows from the header; check it before allocating the tables
+    const std::streamoff header = in.tellg();
+    in.seekg(0, std::ios::end);
+    const uint64_t payload = (uint64_t)(in.tellg() - header);
+    in.seekg(header);
+    if (payload != sizeof(int) * (uint64_t)file_k + 2 * sizeof(double) * (uint64_t)file_n * file_k) {
+        std::cerr << "Truncated landmark file: " << path << "\n";
+        return false;
+    }
+    std::vector<int> ids(file_k);
+    std::vector<double> f((size_t)file_n*file_k), t((size_t)file_n*file_k);
+    in.read(reinterpret_cast<char*>(ids.data()), sizeof(int)*ids.size());
+    in.read(reinterpret_cast<char*>(f.data()), sizeof(double)*f.size());
+    in.read(reinterpret_cast<char*>(t.data()), sizeof(double)*t.size());
+    if (!in) { std::cerr << "Truncated landmark file: " << path << "\n"; return false; }
+    n = file_n; k = file_k; metric_ = file_metric; fingerprint_ = fingerprint;
+    landmark_ids.swap(ids);
+    from.swap(f);
+    to.swap(t);
+    return true;
+}
@@ -0,0 +1,62 @@
+#ifndef LANDMARKS_H
+#define LANDMARKS_H
+
+#include "graph.h"
+#include <cstdint>
+#include <vector>
+#include <string>
+#include <limits>
+
+enum class LandmarkSelection { Farthest, Avoid };
+
+/* ALT landmark tables.
+   For every node u and landmark l we keep d(l,u) and d(u,l); by the triangle
+   inequality max_l max(d(l,t)-d(l,u), d(u,l)-d(t,l)) is a lower bound on
+   d(u,t) in the graph's own weight units, so it is admissible for A*
+   whatever the weights mean (km, meters, minutes).
+   Tables are node-major (K entries per node) so one heuristic call reads
+   two contiguous rows.
+*/
+class Landmarks {
+public:
+    Landmarks() = default;
+    // select k landmarks and compute the tables with one Dijkstra per landmark and direction,
+    // on the given edge metric (the bounds only hold for that metric)
+    void build(const Graph &g, int k, LandmarkSelection sel = LandmarkSelection::Avoid,
+               int threads = 0, unsigned seed = 1, int metric = 0);
+    bool save(const std::string &path) const;
+    // fails if the file does not exist or was built for another graph, node numbering or metric
+    // (checked through a fingerprint of the ids, edges and weights); files older than that fail too
+    bool load(const std::string &path, const Graph &g, int metric = 0);
+
+    int count() const { return k; }
+    int metric() const { return metric_; }
+    const std::vector<int>& ids() const { return landmark_ids; }
+    bool empty() const { return k == 0; }
+
+    double lower_bound(int u, int t) const {
+        const double *fu = &from[(size_t)u*k], *ft = &from[(size_t)t*k];
+        const double *tu = &to[(size_t)u*k], *tt = &to[(size_t)t*k];
+        double best = 0.0;
+        for (int i = 0; i < k; ++i) {
+            // unreachable entries are +inf; inf - inf is NaN and never wins the comparison
+            double a = ft[i] - fu[i];
+            double b = tu[i] - tt[i];
+            if (a > best && a != INF_) best = a;
+            if (b > best && b != INF_) best = b;
+        }
+        return best;
+    }
+
+private:
+    static constexpr double INF_ = std::numeric_limits<double>::infinity();
+    int k = 0;
+    int n = 0;
+    int metric_ = 0;
+    uint64_t fingerprint_ = 0;  // graph_fingerprint() of the graph and metric the tables were built for
+    std::vector<int> landmark_ids;
+    std::vector<double> from; // from[u*k+i] = d(landmark i, u)
+    std::vector<double> to;   // to[u*k+i]   = d(u, landmark i)
+};
+
+#endif // LANDMARKS_H
@@ -0,0 +1,81 @@
+#include "latency_histogram.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+constexpr uint64_t SUB = 1ULL << LatencyHistogram::SUB_BITS;
+constexpr uint64_t MAX_VALUE = (1ULL << LatencyHistogram::MAX_BITS) - 1;
+
+inline int msb(uint64_t v) { return 63 - __builtin_clzll(v); }
+}
+
+LatencyHistogram::LatencyHistogram()
+    : counts((size_t)(MAX_BITS - SUB_BITS + 1) * SUB, 0) {}
+
+size_t LatencyHistogram::index_of(uint64_t v) {
+    if (v < 2 * SUB) return (size_t)v;
+    int shift = msb(v) - SUB_BITS;
+    return (size_t)((shift + 1) * SUB + ((v >> shift) - SUB));
+}
+
+uint64_t LatencyHistogram::lowest_of(size_t idx) {
+    if (idx < 2 * SUB) return idx;
+    int shift = (int)(idx / SUB) - 1;
+    return (SUB + idx % SUB) << shift;
+}
+
+uint64_t LatencyHistogram::highest_of(size_t idx) {
+    if (idx < 2 * SUB) return idx;
+    int shift = (int)(idx / SUB) - 1;
+    return lowest_of(idx) + (1ULL << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t ns) {
+    ns = std::min(ns, MAX_VALUE);
+    counts[index_of(ns)]++;
+    total++;
+    sum += ns;
+    min_ = std::min(min_, ns);
+    max_ = std::max(max_, ns);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &o) {
+    for (size_t i = 0; i < counts.size(); ++i) counts[i] += o.counts[i];
+    total += o.total;
+    sum += o.sum;
+    min_ = std::min(min_, o.min_);
+    max_ = std::max(max_, o.max_);
+}
+
+void LatencyHistogram::clear() {
+    std::fill(counts.begin(), counts.end(), 0);
+    total = 0;
+    sum = 0;
+    min_ = UINT64_MAX;
+    max_ = 0;
+}
+
+uint64_t LatencyHistogram::percentile(double p) const {
+    if (total == 0) return 0;
+    if (p <= 0) return min();
+    if (p >= 100) return max_;
+    uint64_t rank = std::max<uint64_t>(1, (uint64_t)std::ceil(p / 100.0 * total));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < counts.size(); ++i) {
+        seen += counts[i];
+        // the bucket's upper edge, but never above what was actually recorded
+        if (seen >= rank) return std::max(min(), std::min(highest_of(i), max_));
+    }
+    return max_;
+}
+
+std::vector<LatencyHistogram::Bucket> LatencyHistogram::buckets() const {
+    std::vector<Bucket> out;
+    for (size_t i = 0; i < counts.size(); ++i)
+        if (counts[i]) out.push_back({lowest_of(i), highest_of(i), counts[i]});
+    if (!out.empty()) {
+        out.front().low = std::max(out.front().low, min_);
+        out.back().high = std::min(out.back().high, max_);
+    }
+    return out;
+}
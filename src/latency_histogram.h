@@ -0,0 +1,51 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/* Fixed-memory high-dynamic-range latency histogram (HdrHistogram layout).
+   Values are nanoseconds. Below 2^(SUB_BITS+1) every value has its own
+   bucket; above, each power-of-two range is split into 2^SUB_BITS linear
+   buckets, so a recorded value is off by at most 1/2^SUB_BITS (< 0.8%)
+   of itself. Values above MAX_BITS are clamped into the last bucket.
+   The memory is ~40 KB whatever the number of samples, and two
+   histograms merge by adding counts, so each worker records into its own
+   and the runner merges them at the end.
+*/
+class LatencyHistogram {
+public:
+    static constexpr int SUB_BITS = 7;    // 128 sub-buckets per power of two
+    static constexpr int MAX_BITS = 44;   // ~4.9 hours in ns
+
+    LatencyHistogram();
+
+    void record(uint64_t ns);
+    void merge(const LatencyHistogram &o);
+    void clear();
+
+    uint64_t count() const { return total; }
+    uint64_t min() const { return total ? min_ : 0; }
+    uint64_t max() const { return max_; }
+    double mean() const { return total ? (double)sum / total : 0.0; }
+    // smallest recorded value v such that p% of the samples are <= v, to bucket precision (p in [0, 100])
+    uint64_t percentile(double p) const;
+
+    // non-empty buckets as (lowest value, highest value, count); the first and last
+    // are narrowed to min() and max(), so consumers of the buckets alone see the recorded range
+    struct Bucket { uint64_t low, high, count; };
+    std::vector<Bucket> buckets() const;
+
+private:
+    std::vector<uint64_t> counts;
+    uint64_t total = 0;
+    uint64_t min_ = UINT64_MAX, max_ = 0;
+    long double sum = 0;
+
+    static size_t index_of(uint64_t v);
+    static uint64_t lowest_of(size_t idx);
+    static uint64_t highest_of(size_t idx);
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -1,38 +1,94 @@
 #include "graph.h"
 #include "planner.h"
 #include "io.h"
+#include "spatial_index.h"
 #include <iostream>
 #include <filesystem>
 #include <iomanip>
+#include <sstream>
+
+// value of `--name value` anywhere in argv, or def
+static std::string flag_value(int argc, char** argv, const std::string &name, const std::string &def) {
+    for (int i = 1; i+1 < argc; ++i) if (argv[i] == name) return argv[i+1];
+    return def;
+}
+
+// "lat,lon" when the argument contains a comma, otherwise a node id
+static bool parse_lat_lon(const std::string &arg, double &lat, double &lon) {
+    size_t comma = arg.find(',');
+    if (comma == std::string::npos) return false;
+    lat = std::stod(arg.substr(0, comma));
+    lon = std::stod(arg.substr(comma + 1));
+    return true;
+}
 
 // simple driver: single query; prints metrics, produces visualization
 int main(int argc, char** argv) {
-    std::cout << "Travel Route Planner (Dijkstra, A*, Bidirectional A*)\n";
-    if (argc < 5) {
-        std::cout << "Usage: " << argv[0] << " <cities.csv> <routes.csv> <source_id> <target_id>\n";
+    std::cout << "Travel Route Planner (Dijkstra, A*, Bidirectional A*, CH)\n";
+    std::vector<std::string> pos;
+    bool directed = false, with_ch = true;
+    for (int i = 1; i < argc; ++i) {
+        // the only flags without a value
+        if (std::string(argv[i]) == "--directed") { directed = true; continue; }
+        if (std::string(argv[i]) == "--no-ch") { with_ch = false; continue; }
+        if (std::string(argv[i]).rfind("--", 0) == 0) { ++i; continue; }
+        pos.push_back(argv[i]);
+    }
+    // a binary snapshot replaces the cities.csv / routes.csv pair
+    bool snapshot = !pos.empty() && Graph::is_snapshot(pos[0]);
+    size_t graph_args = snapshot ? 1 : 2;
+    if (pos.size() < graph_args + 2) {
+        std::cout << "Usage: " << argv[0] << " <cities.csv> <routes.csv> <source> <target> [--landmarks K] [--landmark-file path] [--reorder hilbert|bfs]\n";
+        std::cout << "       [--directed] [--metric NAME] [--no-ch] [--isochrone B1,B2,... [--cell-km C]]\n";
+        std::cout << "       " << argv[0] << " <graph.rpg> <source> <target> [...]\n";
+        std::cout << "source/target: a node id, or lat,lon snapped to the nearest node\n";
         return 1;
     }
-    std::string nodes_csv = argv[1];
-    std::string edges_csv = argv[2];
-    int source = std::stoi(argv[3]);
-    int target = std::stoi(argv[4]);
 
     Graph g;
-    if (!g.load_nodes_csv(nodes_csv)) return 2;
-    if (!g.load_edges_csv(edges_csv)) return 3;
+    if (snapshot) {
+        if (!g.load_snapshot(pos[0])) return 2;
+    } else {
+        if (!g.load_nodes_csv(pos[0])) return 2;
+        if (!g.load_edges_csv(pos[1], !directed)) return 3;
+    }
     std::cout << "Loaded graph: nodes=" << g.num_nodes() << " edges(approx)=";
-    size_t edgecount = 0;
-    for (const auto &v : g.adjacency()) edgecount += v.size();
-    std::cout << edgecount/2 << " (undirected)\n";
+    if (g.is_directed()) std::cout << g.num_edges() << " (directed)\n";
+    else std::cout << g.num_edges()/2 << " (undirected)\n";
+    SearchContext ctx;
+    std::string metric_name = flag_value(argc, argv, "--metric", g.metric_name(0));
+    ctx.metric = g.find_metric(metric_name);
+    if (ctx.metric < 0) { std::cerr << "Unknown metric: " << metric_name << "\n"; return 1; }
+    if (g.num_metrics() > 1) std::cout << "Metric: " << g.metric_name(ctx.metric) << "\n";
+    NodeOrder order = NodeOrder::Input;
+    if (!parse_node_order(flag_value(argc, argv, "--reorder", "input"), order)) { std::cerr << "Unknown order\n"; return 1; }
+    g.reorder(order);
+
+    // resolve source/target to internal ids; coordinates are snapped through a spatial index
+    SpatialIndex snap;
+    auto resolve = [&](const std::string &arg) -> int {
+        double lat, lon;
+        if (!parse_lat_lon(arg, lat, lon)) {
+            int id = std::stoi(arg);
+            return (id >= 0 && id < g.num_nodes()) ? g.to_internal(id) : id;
+        }
+        if (snap.empty()) snap.build(g);
+        int id = snap.nearest(lat, lon);
+        if (id >= 0) std::cout << "Snapped " << arg << " to node " << g.to_external(id) << " (" << g.get_names()[id] << "), "
+                               << snap.distance_km(lat, lon, id) << " km away\n";
+        return id;
+    };
+    int source = resolve(pos[graph_args]);
+    int target = resolve(pos[graph_args+1]);
 
     // Print adjacency list
-    const auto &adj = g.adjacency();
-    const auto &names = g.get_names();
+    auto names = g.get_names();
     std::cout << "Adjacency List:\n";
-    for (size_t i = 0; i < adj.size(); ++i) {
-        std::cout << i << " (" << names[i] << "): ";
-        for (const auto &e : adj[i]) {
-            std::cout << e.to << " (" << names[e.to] << ") w=" << e.w << ", ";
+    for (int x = 0; x < g.num_nodes(); ++x) {
+        int i = g.to_internal(x);
+        std::cout << x << " (" << names[i] << "): ";
+        for (const auto &e : g.neighbors(i, ctx.metric)) {
+            std::cout << g.to_external(e.to) << " (" << names[e.to] << ") w=" << e.w << ", ";
         }
         std::cout << "\n";
     }
@@ -40,7 +96,7 @@ int main(int argc, char** argv) {
     auto print_path = [&](const std::vector<int> &path) {
         std::cout << "Path: ";
         for (size_t i = 0; i < path.size(); ++i) {
-            std::cout << path[i] << " (" << names[path[i]] << ")";
+            std::cout << g.to_external(path[i]) << " (" << names[path[i]] << ")";
             if (i+1 < path.size()) std::cout << " -> ";
         }
         std::cout << "\n";
@@ -52,15 +108,45 @@ int main(int argc, char** argv) {
         print_path(st.path);
     };
 
-    Stats sd = dijkstra_search(g, source, target);
+    Stats sd = dijkstra_search(g, source, target, ctx);
     run_and_print("DIJKSTRA", sd);
 
-    Stats sa = astar_search(g, source, target);
+    Stats sa = astar_search(g, source, target, ctx);
     run_and_print("ASTAR", sa);
 
-    Stats sb = bidir_astar_search(g, source, target);
+    Stats sbd = bidir_dijkstra_search(g, source, target, ctx);
+    run_and_print("BIDIR_DIJKSTRA", sbd);
+
+    Stats sb = bidir_astar_search(g, source, target, ctx);
     run_and_print("BIDIR_ASTAR", sb);
 
+    // the hierarchy is built per run, which dominates a single query on large graphs
+    Stats sc;
+    if (with_ch) {
+        ContractionHierarchy ch;
+        ch.build(g, ctx.metric);
+        sc = ch_search(ch, source, target, ctx);
+        run_and_print("CH", sc);
+    }
+
+    // ALT variants: landmark tables are loaded from --landmark-file when present
+    int num_landmarks = std::stoi(flag_value(argc, argv, "--landmarks", "0"));
+    std::string landmark_file = flag_value(argc, argv, "--landmark-file", "");
+    Landmarks lm;
+    std::vector<std::pair<std::string, Stats>> alt_rows;
+    if (num_landmarks > 0 || !landmark_file.empty()) {
+        if (landmark_file.empty() || !lm.load(landmark_file, g, ctx.metric)) {
+            lm.build(g, num_landmarks > 0 ? num_landmarks : 16, LandmarkSelection::Avoid, 0, 1, ctx.metric);
+            if (!landmark_file.empty()) lm.save(landmark_file);
+        }
+        Stats sal = astar_search(g, source, target, ctx, &lm);
+        run_and_print("ASTAR_ALT", sal);
+        Stats sbl = bidir_astar_search(g, source, target, ctx, &lm);
+        run_and_print("BIDIR_ASTAR_ALT", sbl);
+        alt_rows.push_back({"astar_alt", sal});
+        alt_rows.push_back({"bidir_astar_alt", sbl});
+    }
+
     std::filesystem::create_directories("results");
     std::string geo = "results/route.geojson";
     if (!write_geojson(g, sb.path.empty() ? sa.path : sb.path, geo)) {
@@ -70,10 +156,30 @@ int main(int argc, char** argv) {
         std::cout << "Visualization: results/route_map.html\n";
     }
 
+    // ranges around the source for each budget, drawn as nested polygons
+    std::string budgets = flag_value(argc, argv, "--isochrone", "");
+    if (!budgets.empty()) {
+        std::vector<RangeResult> ranges;
+        std::stringstream list(budgets);
+        for (std::string b; std::getline(list, b, ',');) {
+            ranges.push_back(range_search(g, source, std::stod(b), ctx));
+            const RangeResult &r = ranges.back();
+            std::cout << "RANGE budget=" << r.budget << " nodes=" << r.nodes.size() << " frontier=" << r.frontier.size() << " ms=" << r.millis << "\n";
+        }
+        double cell_km = std::stod(flag_value(argc, argv, "--cell-km", "0"));
+        if (write_isochrone_geojson(g, ranges, "results/isochrone.geojson", cell_km)) {
+            write_leaflet_html("isochrone.geojson", "results/isochrone_map.html");
+            std::cout << "Isochrones: results/isochrone_map.html\n";
+        }
+    }
+
     std::vector<std::pair<std::string, Stats>> rows;
     rows.push_back({"dijkstra", sd});
     rows.push_back({"astar", sa});
+    rows.push_back({"bidir_dijkstra", sbd});
     rows.push_back({"bidir_astar", sb});
+    if (with_ch) rows.push_back({"ch", sc});
+    rows.insert(rows.end(), alt_rows.begin(), alt_rows.end());
     write_metrics_csv("results/metrics.csv", rows);
     std::cout << "Metrics saved to results/metrics.csv\n";
 
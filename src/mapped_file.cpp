@@ -0,0 +1,50 @@
+#include "mapped_file.h"
+#include <fstream>
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define ROUTE_HAVE_MMAP 1
+#endif
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string &path) {
+    close();
+#ifdef ROUTE_HAVE_MMAP
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;
+    struct stat sb;
+    if (fstat(fd, &sb) != 0) { ::close(fd); return false; }
+    len = (size_t)sb.st_size;
+    if (len == 0) { ::close(fd); opened_empty = true; return true; }
+    void *p = mmap(nullptr, len, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) { len = 0; return false; }
+    ptr = static_cast<const char*>(p);
+    mapped = true;
+    return true;
+#else
+    std::ifstream in(path, std::ios::binary | std::ios::ate);
+    if (!in.is_open()) return false;
+    len = (size_t)in.tellg();
+    in.seekg(0);
+    buffer.resize(len);
+    if (len && !in.read(buffer.data(), len)) { len = 0; buffer.clear(); return false; }
+    ptr = buffer.data();
+    opened_empty = (len == 0);
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#ifdef ROUTE_HAVE_MMAP
+    if (mapped && ptr) munmap(const_cast<char*>(ptr), len);
+#endif
+    ptr = nullptr;
+    len = 0;
+    mapped = false;
+    opened_empty = false;
+    buffer.clear();
+}
@@ -0,0 +1,34 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+/* Read-only view of a whole file.
+   On POSIX systems the file is mmap'ed so its pages are shared with the
+   page cache and nothing is copied; elsewhere it is read into a buffer.
+*/
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string &path);
+    void close();
+
+    const char* data() const { return ptr; }
+    size_t size() const { return len; }
+    bool is_open() const { return ptr != nullptr || opened_empty; }
+
+private:
+    const char *ptr = nullptr;
+    size_t len = 0;
+    bool mapped = false;
+    bool opened_empty = false;
+    std::vector<char> buffer; // fallback storage when mmap is unavailable
+};
+
+#endif // MAPPED_FILE_H
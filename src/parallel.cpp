@@ -0,0 +1,56 @@
+#include "parallel.h"
+
+ThreadPool::ThreadPool(int threads): num_threads(threads < 1 ? 1 : threads) {
+    if (num_threads == 1) return;
+    for (int i = 0; i < num_threads; ++i) workers.emplace_back(&ThreadPool::worker_loop, this, i);
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mu);
+        stopping = true;
+    }
+    job_cv.notify_all();
+    for (auto &th : workers) th.join();
+}
+
+void ThreadPool::for_each(int n, int chunk, const std::function<void(int,int)> &fn) {
+    if (n <= 0) return;
+    if (workers.empty()) {
+        for (int i = 0; i < n; ++i) fn(i, 0);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mu);
+    job = &fn;
+    job_n = n;
+    job_chunk = chunk < 1 ? 1 : chunk;
+    next = 0;
+    busy = num_threads;
+    ++generation;
+    job_cv.notify_all();
+    done_cv.wait(lock, [&]{ return busy == 0; });
+    job = nullptr;
+}
+
+void ThreadPool::worker_loop(int id) {
+    unsigned long seen = 0;
+    while (true) {
+        const std::function<void(int,int)> *fn;
+        int n, chunk;
+        {
+            std::unique_lock<std::mutex> lock(mu);
+            job_cv.wait(lock, [&]{ return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            fn = job; n = job_n; chunk = job_chunk;
+        }
+        for (int b = next.fetch_add(chunk); b < n; b = next.fetch_add(chunk)) {
+            int e = b + chunk < n ? b + chunk : n;
+            for (int i = b; i < e; ++i) (*fn)(i, id);
+        }
+        {
+            std::lock_guard<std::mutex> lock(mu);
+            if (--busy == 0) done_cv.notify_all();
+        }
+    }
+}
@@ -0,0 +1,69 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+inline int default_threads() {
+    unsigned h = std::thread::hardware_concurrency();
+    return h ? (int)h : 1;
+}
+
+/* Run fn(i) for every i in [0, n) on up to `threads` workers.
+   Workers pull indices from a shared counter, so uneven items balance out.
+   threads <= 1 runs inline on the calling thread.
+*/
+template <typename Fn>
+void parallel_for(int n, int threads, Fn fn) {
+    if (threads <= 1 || n <= 1) {
+        for (int i = 0; i < n; ++i) fn(i);
+        return;
+    }
+    std::atomic<int> next{0};
+    std::vector<std::thread> pool;
+    int workers = threads < n ? threads : n;
+    for (int w = 0; w < workers; ++w) {
+        pool.emplace_back([&]() {
+            for (int i = next++; i < n; i = next++) fn(i);
+        });
+    }
+    for (auto &th : pool) th.join();
+}
+
+/* Fixed set of worker threads reused across jobs.
+   for_each() hands out chunks of indices from a shared counter and passes
+   the worker id, so callers can keep per-worker state (search contexts,
+   result buffers) without locking. With one thread it runs inline.
+*/
+class ThreadPool {
+public:
+    explicit ThreadPool(int threads);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    int size() const { return num_threads; }
+    // fn(i, worker) for every i in [0, n); blocks until all indices are done
+    void for_each(int n, int chunk, const std::function<void(int,int)> &fn);
+
+private:
+    int num_threads;
+    std::vector<std::thread> workers;
+    std::mutex mu;
+    std::condition_variable job_cv, done_cv;
+    // current job
+    const std::function<void(int,int)> *job = nullptr;
+    int job_n = 0, job_chunk = 1;
+    std::atomic<int> next{0};
+    int busy = 0;
+    unsigned long generation = 0;
+    bool stopping = false;
+
+    void worker_loop(int id);
+};
+
+#endif // PARALLEL_H
@@ -1,29 +1,13 @@
-#include <iostream>
 #include "planner.h"
+#include "parallel.h"
 #include <queue>
 #include <limits>
 #include <cmath>
 #include <chrono>
 #include <algorithm>
 #include <unordered_map>
-#ifndef M_PI
-#define M_PI 3.14159265358979323846
-#endif
-
-static inline double haversine_km(double lat1,double lon1,double lat2,double lon2){
-    // returns distance in kilometers
-    const double R = 6371.0;
-    double toRad = M_PI / 180.0;
-    double dLat = (lat2 - lat1) * toRad;
-    double dLon = (lon2 - lon1) * toRad;
-    double a = std::sin(dLat/2)*std::sin(dLat/2) +
-               std::cos(lat1*toRad)*std::cos(lat2*toRad) *
-               std::sin(dLon/2)*std::sin(dLon/2);
-    double c = 2*std::atan2(std::sqrt(a), std::sqrt(1-a));
-    return R * c;
-}
 
-static std::vector<int> reconstruct_parent(const std::vector<int>& parent, int s, int t) {
+std::vector<int> reconstruct_path(const std::vector<int>& parent, int s, int t) {
     std::vector<int> path;
     if (t < 0 || t >= (int)parent.size()) return {};
     int cur = t;
@@ -38,218 +22,865 @@ static std::vector<int> reconstruct_parent(const std::vector<int>& parent, int s
 }
 
 /* Dijkstra: lazy PQ (stale entries skipped)
-   Returns Stats with nodes_expanded and time (ms)
+   Returns Stats with nodes_expanded and time (ms); t == -1 settles every
+   reachable node (the tree stays in ctx.fwd)
 */
-Stats dijkstra_search(const Graph &g, int s, int t) {
-    const auto &adj = g.adjacency();
-    const int n = (int)adj.size();
+template <typename Queue>
+static Stats dijkstra_kernel(const Graph &g, int s, int t, SearchContext &ctx, Queue &pq) {
+    const int n = g.num_nodes();
     Stats st;
-    if (s<0||s>=n||t<0||t>=n) return st;
-    const double INF = std::numeric_limits<double>::infinity();
-    std::vector<double> dist(n, INF);
-    std::vector<int> parent(n, -1);
-    using PQ = std::pair<double,int>;
-    std::priority_queue<PQ, std::vector<PQ>, std::greater<PQ>> pq;
-    dist[s] = 0.0;
-    pq.push({0.0, s});
+    if (s<0||s>=n||t<-1||t>=n) return st;
+    TraceScope trace("dijkstra", s, t);
+    SearchCounters &c = st.counters;
+    PhaseClock phase;
+    ctx.prepare(n);
+    auto &dist = ctx.fwd.dist;
+    ctx.fwd.set(s, 0.0, -1);
+    pq.push(0.0, s);
+    const int metric = ctx.metric;
     size_t expanded = 0;
+    c.setup_ns = phase.lap();
 
     auto t0 = std::chrono::high_resolution_clock::now();
     while (!pq.empty()) {
-        auto [d,u] = pq.top(); pq.pop();
-        if (d != dist[u]) continue; // stale
+        auto [d,u] = pq.pop();
+        if (d != dist[u]) { ROUTE_COUNT(c.stale_pops); continue; }
         expanded++;
         if (u == t) break;
-        for (const auto &e : adj[u]) {
+        for (const auto &e : g.neighbors(u, metric)) {
+            ROUTE_COUNT(c.relaxations);
             if (dist[u] + e.w < dist[e.to]) {
-                dist[e.to] = dist[u] + e.w;
-                parent[e.to] = u;
-                pq.push({dist[e.to], e.to});
+                ROUTE_COUNT(c.improvements);
+                ctx.fwd.set(e.to, dist[u] + e.w, u);
+                pq.push(dist[e.to], e.to);
             }
         }
     }
     auto t1 = std::chrono::high_resolution_clock::now();
-    st.distance = dist[t];
+    c.search_ns = phase.lap();
+    st.distance = t >= 0 ? dist[t] : 0.0;
     st.nodes_expanded = expanded;
+    st.pq_pushes = pq.pushes;
+    st.pq_max_size = pq.max_size;
     st.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
-    st.path = reconstruct_parent(parent, s, t);
+    st.path = reconstruct_path(ctx.fwd.parent, s, t);
+    c.path_ns = phase.lap();
     return st;
 }
 
-/* A* using Haversine heuristic (lat/lon in degrees)
+Stats dijkstra_search(const Graph &g, int s, int t, SearchContext &ctx) {
+    switch (ctx.queue) {
+        case QueueKind::Radix: return dijkstra_kernel(g, s, t, ctx, ctx.fwd.radix);
+        case QueueKind::Dary: return dijkstra_kernel(g, s, t, ctx, ctx.fwd.dary);
+        default: return dijkstra_kernel(g, s, t, ctx, ctx.fwd.binary);
+    }
+}
+
+Stats dijkstra_search(const Graph &g, int s, int t) {
+    SearchContext ctx;
+    return dijkstra_search(g, s, t, ctx);
+}
+
+ShortestPathTree dijkstra_tree(const Graph &g, int s, SearchContext &ctx) {
+    ShortestPathTree tree;
+    const int n = g.num_nodes();
+    if (s < 0 || s >= n) return tree;
+    Stats st = dijkstra_search(g, s, -1, ctx);
+    tree.dist.assign(ctx.fwd.dist.begin(), ctx.fwd.dist.begin() + n);
+    tree.parent.assign(ctx.fwd.parent.begin(), ctx.fwd.parent.begin() + n);
+    tree.settled = st.nodes_expanded;
+    tree.millis = st.millis;
+    return tree;
+}
+
+ShortestPathTree dijkstra_tree(const Graph &g, int s, int metric) {
+    SearchContext ctx;
+    ctx.metric = metric;
+    return dijkstra_tree(g, s, ctx);
+}
+
+// Dijkstra that stops at the first node beyond the budget; everything settled before is in range
+template <typename Queue>
+static RangeResult range_kernel(const Graph &g, int s, double budget, SearchContext &ctx, Queue &pq) {
+    RangeResult r;
+    r.source = s;
+    r.budget = budget;
+    r.metric = ctx.metric;
+    const int n = g.num_nodes();
+    if (s < 0 || s >= n || !(budget >= 0)) return r;
+    TraceScope trace("range", s, -1);
+    ctx.prepare(n);
+    auto &dist = ctx.fwd.dist;
+    ctx.fwd.set(s, 0.0, -1);
+    pq.push(0.0, s);
+    const int metric = ctx.metric;
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    while (!pq.empty()) {
+        auto [d,u] = pq.pop();
+        if (d != dist[u]) continue;
+        if (d > budget) break;
+        r.nodes.push_back(u);
+        r.dist.push_back(d);
+        for (const auto &e : g.neighbors(u, metric)) {
+            if (d + e.w < dist[e.to]) {
+                ctx.fwd.set(e.to, d + e.w, u);
+                pq.push(dist[e.to], e.to);
+            }
+        }
+    }
+    // nodes left with a tentative distance beyond the budget are out of range for good
+    for (size_t i = 0; i < r.nodes.size(); ++i) {
+        for (const auto &e : g.neighbors(r.nodes[i], metric)) {
+            if (dist[e.to] > budget && std::isfinite(e.w))
+                r.frontier.push_back({r.nodes[i], e.to, e.w > 0 ? (budget - r.dist[i]) / e.w : 0.0});
+        }
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    r.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    return r;
+}
+
+RangeResult range_search(const Graph &g, int s, double budget, SearchContext &ctx) {
+    switch (ctx.queue) {
+        case QueueKind::Radix: return range_kernel(g, s, budget, ctx, ctx.fwd.radix);
+        case QueueKind::Dary: return range_kernel(g, s, budget, ctx, ctx.fwd.dary);
+        default: return range_kernel(g, s, budget, ctx, ctx.fwd.binary);
+    }
+}
+
+RangeResult range_search(const Graph &g, int s, double budget, int metric) {
+    SearchContext ctx;
+    ctx.metric = metric;
+    return range_search(g, s, budget, ctx);
+}
+
+/* A* using Haversine heuristic (lat/lon in degrees),
+   or the ALT landmark lower bound when landmarks are supplied
 */
-Stats astar_search(const Graph &g, int s, int t) {
-    const auto &adj = g.adjacency();
+template <typename Queue>
+static Stats astar_kernel(const Graph &g, int s, int t, SearchContext &ctx, const Landmarks *lm, Queue &open) {
     const auto &coords = g.get_coords(); // lat,lon
-    const int n = (int)adj.size();
+    const int n = g.num_nodes();
     Stats st;
     if (s<0||s>=n||t<0||t>=n) return st;
-    const double INF = std::numeric_limits<double>::infinity();
-    std::vector<double> gscore(n, INF), fscore(n, INF);
-    std::vector<int> parent(n, -1);
-    std::vector<char> closed(n, 0);
+    TraceScope trace(lm ? "astar_alt" : "astar", s, t);
+    SearchCounters &c = st.counters;
+    PhaseClock phase;
+    ctx.prepare(n);
+    auto &gscore = ctx.fwd.dist;
+    auto &closed = ctx.fwd.closed;
 
+    const bool alt = lm && !lm->empty() && lm->metric() == ctx.metric;
+    const int metric = ctx.metric;
     auto h = [&](int u)->double {
+        ROUTE_COUNT(c.heuristic_evals);
+        if (alt) return lm->lower_bound(u, t);
         // return haversine_km(coords[u].first, coords[u].second, coords[t].first, coords[t].second);
         double dx = coords[u].first - coords[t].first;
         double dy = coords[u].second - coords[t].second;
         return std::sqrt(dx*dx + dy*dy);
     };
 
-    struct Node { double f; int v; };
-    struct Cmp { bool operator()(const Node &a, const Node &b) const { return a.f > b.f; } };
-    std::priority_queue<Node, std::vector<Node>, Cmp> open;
-    gscore[s] = 0.0;
-    fscore[s] = h(s);
-    open.push({fscore[s], s});
+    ctx.fwd.set(s, 0.0, -1);
+    open.push(h(s), s);
     size_t expanded = 0;
+    c.setup_ns = phase.lap();
     auto t0 = std::chrono::high_resolution_clock::now();
 
     while (!open.empty()) {
-        Node cur = open.top(); open.pop();
-        int u = cur.v;
-        if (closed[u]) continue;
+        int u = open.pop().second;
+        if (closed[u]) { ROUTE_COUNT(c.stale_pops); continue; }
         closed[u] = 1;
         expanded++;
         if (u == t) break;
-        for (const auto &e : adj[u]) {
+        for (const auto &e : g.neighbors(u, metric)) {
+            ROUTE_COUNT(c.relaxations);
             int v = e.to;
             if (closed[v]) continue;
             double tentative = gscore[u] + e.w;
             if (tentative < gscore[v]) {
-                gscore[v] = tentative;
-                parent[v] = u;
-                fscore[v] = tentative + h(v);
-                open.push({fscore[v], v});
+                ROUTE_COUNT(c.improvements);
+                ctx.fwd.set(v, tentative, u);
+                open.push(tentative + h(v), v);
             }
         }
     }
     auto t1 = std::chrono::high_resolution_clock::now();
+    c.search_ns = phase.lap();
     st.distance = gscore[t];
     st.nodes_expanded = expanded;
+    st.pq_pushes = open.pushes;
+    st.pq_max_size = open.max_size;
     st.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
-    st.path = reconstruct_parent(parent, s, t);
+    st.path = reconstruct_path(ctx.fwd.parent, s, t);
+    c.path_ns = phase.lap();
     return st;
 }
 
-/* Bidirectional A*:
-   - Run A* (forward from s, backward from t) with heuristic h_f(u)=h(u,t), h_b(u)=h(u,s).
-   - Maintain g_f,g_b maps and parent arrays.
-   - When searches meet, compute best path via meeting node.
-   - Stop criterion: when min_f_in_open_forward + min_f_in_open_backward >= best_found
-   Note: uses Haversine heuristic.
+Stats astar_search(const Graph &g, int s, int t, SearchContext &ctx, const Landmarks *lm) {
+    switch (ctx.queue) {
+        case QueueKind::Radix: return astar_kernel(g, s, t, ctx, lm, ctx.fwd.radix);
+        case QueueKind::Dary: return astar_kernel(g, s, t, ctx, lm, ctx.fwd.dary);
+        default: return astar_kernel(g, s, t, ctx, lm, ctx.fwd.binary);
+    }
+}
+
+Stats astar_search(const Graph &g, int s, int t, const Landmarks *lm) {
+    SearchContext ctx;
+    return astar_search(g, s, t, ctx, lm);
+}
+
+/* Bidirectional search (Ikeda et al. / Goldberg-Harrelson):
+   - Forward from s and backward from t with the averaged potentials
+     p_f(v) = (pi_t(v) - pi_s(v)) / 2 and p_b(v) = -p_f(v), where pi_t is
+     a lower bound on d(v,t) and pi_s one on d(s,v). Both searches then run
+     Dijkstra on the same reduced costs w(u,v) - p_f(u) + p_f(v) >= 0, so
+     they stay consistent with each other.
+   - Queue keys are reduced distances (g_f + p_f(v) - p_f(s), g_b + p_b(v) - p_b(t)),
+     which are >= 0 and monotone, as the radix heap requires.
+   - Every scanned edge whose head carries a label from the other side
+     updates best; the search stops once top_f + top_b >= reduced best,
+     the bidirectional Dijkstra criterion on the reduced graph.
+   - Each step expands the side with the smaller queue.
+   The backward side scans g.in_neighbors(), so directed graphs work too.
+   With a zero potential this is plain bidirectional Dijkstra.
 */
-Stats bidir_astar_search(const Graph &g, int s, int t) {
-    const auto &adj = g.adjacency();
-    const auto &coords = g.get_coords();
-    const int n = (int)adj.size();
+template <typename Queue, typename Potential>
+static Stats bidir_kernel(const Graph &g, int s, int t, SearchContext &ctx, const char *name,
+                          const Potential &pot, Queue &open_f, Queue &open_b) {
+    const int n = g.num_nodes();
     Stats st;
     if (s<0||s>=n||t<0||t>=n) return st;
     if (s==t) { st.distance = 0; st.nodes_expanded = 0; st.millis = 0; st.path = {s}; return st; }
-
-    auto h = [&](int u, int goal)->double {
-        return haversine_km(coords[u].first, coords[u].second, coords[goal].first, coords[goal].second);
-    };
+    TraceScope trace(name, s, t);
+    SearchCounters &c = st.counters;
+    PhaseClock phase;
 
     const double INF = std::numeric_limits<double>::infinity();
-    std::vector<double> g_f(n, INF), g_b(n, INF);
-    std::vector<int> p_f(n, -1), p_b(n, -1);
-    std::vector<char> closed_f(n,0), closed_b(n,0);
-    std::vector<char> seen(n,0);
-
-    struct Node { double f; int v; };
-    struct Cmp { bool operator()(const Node &a, const Node &b) const { return a.f > b.f; } };
-    std::priority_queue<Node, std::vector<Node>, Cmp> open_f, open_b;
+    ctx.prepare(n);
+    auto &g_f = ctx.fwd.dist, &g_b = ctx.bwd.dist;
+    auto &p_f = ctx.fwd.parent, &p_b = ctx.bwd.parent;
+    auto &closed_f = ctx.fwd.closed, &closed_b = ctx.bwd.closed;
 
-    g_f[s] = 0.0; open_f.push({g_f[s] + h(s, t), s});
-    g_b[t] = 0.0; open_b.push({g_b[t] + h(t, s), t});
+    const int metric = ctx.metric;
+    const double pot_s = pot(s, c), pot_t = pot(t, c);
+    ctx.fwd.set(s, 0.0, -1); open_f.push(0.0, s);
+    ctx.bwd.set(t, 0.0, -1); open_b.push(0.0, t);
+    // best in reduced costs is best + p_f(t) - p_f(s)
+    const double offset = pot_t - pot_s;
     double best_path = INF;
     int meeting_node = -1;
     size_t expanded = 0;
-
-    auto relax_neighbors = [&](int u, const std::vector<double>& g_from,
-                               std::vector<double>& g_other, std::vector<int>& parent_from,
-                               const std::priority_queue<Node, std::vector<Node>, Cmp> &dummy){
-        // noop; left for clarity
-    };
+    c.setup_ns = phase.lap();
 
     auto t0 = std::chrono::high_resolution_clock::now();
     while (!open_f.empty() && !open_b.empty()) {
-        double top_f_f = open_f.empty() ? INF : open_f.top().f;
-        double top_f_b = open_b.empty() ? INF : open_b.top().f;
-
-        if (top_f_f + top_f_b >= best_path) break;
+        if (open_f.top_key() + open_b.top_key() >= best_path + offset) break;
 
-        // Expand forward
-        Node cur_f = open_f.top(); open_f.pop();
-        int u_f = cur_f.v;
-        if (closed_f[u_f]) continue;
-        closed_f[u_f] = 1;
-        expanded++;
-        for (const auto &e : adj[u_f]) {
-            int v = e.to;
-            double tentative = g_f[u_f] + e.w;
-            if (tentative < g_f[v]) {
-                g_f[v] = tentative;
-                p_f[v] = u_f;
-                double fscore = tentative + h(v, t);
-                open_f.push({fscore, v});
-            }
-            if (closed_b[v]) {
-                double cand = g_f[v] + g_b[v];
-                if (cand < best_path) { best_path = cand; meeting_node = v; }
-            }
-        }
+        const bool forward = open_f.size() <= open_b.size();
+        Queue &open = forward ? open_f : open_b;
+        SearchContext::Side &side = forward ? ctx.fwd : ctx.bwd;
+        auto &closed = forward ? closed_f : closed_b;
+        const auto &gs = forward ? g_f : g_b;
+        const auto &go = forward ? g_b : g_f;
 
-        // Expand backward
-        Node cur_b = open_b.top(); open_b.pop();
-        int u_b = cur_b.v;
-        if (closed_b[u_b]) continue;
-        closed_b[u_b] = 1;
+        int u = open.pop().second;
+        if (closed[u]) { ROUTE_COUNT(c.stale_pops); continue; }
+        closed[u] = 1;
         expanded++;
-        for (const auto &e : adj[u_b]) {
+        for (const auto &e : forward ? g.neighbors(u, metric) : g.in_neighbors(u, metric)) {
+            ROUTE_COUNT(c.relaxations);
             int v = e.to;
-            double tentative = g_b[u_b] + e.w;
-            if (tentative < g_b[v]) {
-                g_b[v] = tentative;
-                p_b[v] = u_b;
-                double fscore = tentative + h(v, s);
-                open_b.push({fscore, v});
-            }
-            if (closed_f[v]) {
-                double cand = g_f[v] + g_b[v];
-                if (cand < best_path) { best_path = cand; meeting_node = v; }
-            }
+            double tentative = gs[u] + e.w;
+            if (go[v] != INF && tentative + go[v] < best_path) { best_path = tentative + go[v]; meeting_node = v; }
+            if (closed[v] || tentative >= gs[v]) continue;
+            ROUTE_COUNT(c.improvements);
+            side.set(v, tentative, u);
+            open.push(forward ? tentative + pot(v, c) - pot_s : tentative - pot(v, c) + pot_t, v);
         }
     }
 
     auto t1 = std::chrono::high_resolution_clock::now();
+    c.search_ns = phase.lap();
     st.nodes_expanded = expanded;
     st.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    st.pq_pushes = open_f.pushes + open_b.pushes;
+    st.pq_max_size = open_f.max_size + open_b.max_size;
 
     if (best_path == INF) {
-        std::cerr << "[BidirA*] No meeting node found.\n";
         st.distance = INF;
         st.path = {};
         return st;
     }
-    // std::cerr << "[BidirA*] Meeting node: " << meeting_node << ", best_path: " << best_path << "\n";
-    int meet = meeting_node;
-    // build left path from s to meet using p_f
+    // s -> meet along the forward parents, then meet -> t along the backward ones
     std::vector<int> left;
-    for (int cur = meet; cur != -1; cur = p_f[cur]) left.push_back(cur);
+    for (int cur = meeting_node; cur != -1; cur = p_f[cur]) left.push_back(cur);
     std::reverse(left.begin(), left.end());
-    // std::cerr << "[BidirA*] Left path: ";
-    // for (size_t i = 0; i < left.size(); ++i) std::cerr << left[i] << (i+1<left.size()?" -> ":"");
-    // std::cerr << "\n";
-    // build right path from meet to t using p_b (but p_b points towards t)
-    std::vector<int> right;
-    for (int cur = p_b[meet]; cur != -1; cur = p_b[cur]) right.push_back(cur);
-    // std::cerr << "[BidirA*] Right path: ";
-    // for (size_t i = 0; i < right.size(); ++i) std::cerr << right[i] << (i+1<right.size()?" -> ":"");
-    // std::cerr << "\n";
     st.path = left;
-    st.path.insert(st.path.end(), right.begin(), right.end());
+    for (int cur = p_b[meeting_node]; cur != -1; cur = p_b[cur]) st.path.push_back(cur);
     st.distance = best_path;
+    c.path_ns = phase.lap();
+    return st;
+}
+
+// zero potential: bidir_kernel degenerates to bidirectional Dijkstra
+struct ZeroPotential {
+    double operator()(int, SearchCounters &) const { return 0.0; }
+};
+
+/* Averaged geographic potential. haversine_km alone is only a lower bound
+   when edge weights are at least the great-circle length, so it is scaled
+   by Graph::geo_scale(), the smallest weight / km ratio over all edges; the
+   triangle inequality then makes scale * haversine consistent for any weights.
+*/
+template <typename Queue>
+static Stats bidir_astar_kernel(const Graph &g, int s, int t, SearchContext &ctx, const Landmarks *lm,
+                                Queue &open_f, Queue &open_b) {
+    if (s<0||s>=g.num_nodes()||t<0||t>=g.num_nodes()) return Stats();
+    if (lm && !lm->empty() && lm->metric() == ctx.metric) {
+        auto pot = [&](int v, [[maybe_unused]] SearchCounters &c) {
+            ROUTE_COUNT_N(c.heuristic_evals, 2);
+            return 0.5 * (lm->lower_bound(v, t) - lm->lower_bound(s, v));
+        };
+        return bidir_kernel(g, s, t, ctx, "bidir_astar_alt", pot, open_f, open_b);
+    }
+    const auto &coords = g.get_coords();
+    const double half = 0.5 * g.geo_scale(ctx.metric);
+    auto pot = [&](int v, [[maybe_unused]] SearchCounters &c) {
+        ROUTE_COUNT_N(c.heuristic_evals, 2);
+        return half * (haversine_km(coords[v].first, coords[v].second, coords[t].first, coords[t].second)
+                       - haversine_km(coords[s].first, coords[s].second, coords[v].first, coords[v].second));
+    };
+    return bidir_kernel(g, s, t, ctx, "bidir_astar", pot, open_f, open_b);
+}
+
+Stats bidir_astar_search(const Graph &g, int s, int t, SearchContext &ctx, const Landmarks *lm) {
+    switch (ctx.queue) {
+        case QueueKind::Radix: return bidir_astar_kernel(g, s, t, ctx, lm, ctx.fwd.radix, ctx.bwd.radix);
+        case QueueKind::Dary: return bidir_astar_kernel(g, s, t, ctx, lm, ctx.fwd.dary, ctx.bwd.dary);
+        default: return bidir_astar_kernel(g, s, t, ctx, lm, ctx.fwd.binary, ctx.bwd.binary);
+    }
+}
+
+Stats bidir_astar_search(const Graph &g, int s, int t, const Landmarks *lm) {
+    SearchContext ctx;
+    return bidir_astar_search(g, s, t, ctx, lm);
+}
+
+Stats bidir_dijkstra_search(const Graph &g, int s, int t, SearchContext &ctx) {
+    switch (ctx.queue) {
+        case QueueKind::Radix: return bidir_kernel(g, s, t, ctx, "bidir_dijkstra", ZeroPotential(), ctx.fwd.radix, ctx.bwd.radix);
+        case QueueKind::Dary: return bidir_kernel(g, s, t, ctx, "bidir_dijkstra", ZeroPotential(), ctx.fwd.dary, ctx.bwd.dary);
+        default: return bidir_kernel(g, s, t, ctx, "bidir_dijkstra", ZeroPotential(), ctx.fwd.binary, ctx.bwd.binary);
+    }
+}
+
+Stats bidir_dijkstra_search(const Graph &g, int s, int t) {
+    SearchContext ctx;
+    return bidir_dijkstra_search(g, s, t, ctx);
+}
+
+/* Time-dependent Dijkstra / A* (earliest arrival).
+   Labels are the time elapsed since departure, so queue keys start at 0 and
+   grow monotonically whatever the departure time. The edge cost is read at
+   the moment the edge is entered (departure + label of its tail); FIFO
+   profiles keep that cost function monotone, so settling a node is final
+   exactly as in the static kernels. The A* bound is time-independent:
+   prof.geo_scale() is the smallest travel time per km over all edges and
+   times, so geo_scale * haversine is consistent at every departure time.
+*/
+template <typename Queue>
+static Stats td_kernel(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure,
+                       SearchContext &ctx, bool astar, Queue &open) {
+    const int n = g.num_nodes();
+    Stats st;
+    if (s<0||s>=n||t<0||t>=n) return st;
+    if (!prof.empty() && prof.graph_version() != g.version()) return st;
+    TraceScope trace(astar ? "td_astar" : "td_dijkstra", s, t);
+    SearchCounters &c = st.counters;
+    PhaseClock phase;
+    ctx.prepare(n);
+    auto &elapsed = ctx.fwd.dist;
+    auto &closed = ctx.fwd.closed;
+
+    const auto &coords = g.get_coords();
+    const double scale = astar ? prof.geo_scale() : 0.0;
+    auto h = [&](int v)->double {
+        if (!astar) return 0.0;
+        ROUTE_COUNT(c.heuristic_evals);
+        return scale * haversine_km(coords[v].first, coords[v].second, coords[t].first, coords[t].second);
+    };
+    const auto offsets = g.edge_offsets();
+    const int metric = prof.metric();
+    ctx.fwd.set(s, 0.0, -1);
+    open.push(h(s), s);
+    size_t expanded = 0;
+    c.setup_ns = phase.lap();
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    while (!open.empty()) {
+        int u = open.pop().second;
+        if (closed[u]) { ROUTE_COUNT(c.stale_pops); continue; }
+        closed[u] = 1;
+        expanded++;
+        if (u == t) break;
+        const double tau = prof.time_of_day(departure + elapsed[u]);
+        size_t i = offsets[u];
+        for (const auto &e : g.neighbors(u, metric)) {
+            ROUTE_COUNT(c.relaxations);
+            double arrival = elapsed[u] + prof.travel_time_of_day(i++, tau, e.w);
+            if (closed[e.to] || arrival >= elapsed[e.to]) continue;
+            ROUTE_COUNT(c.improvements);
+            ctx.fwd.set(e.to, arrival, u);
+            open.push(arrival + h(e.to), e.to);
+        }
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    c.search_ns = phase.lap();
+    st.distance = elapsed[t];
+    st.nodes_expanded = expanded;
+    st.pq_pushes = open.pushes;
+    st.pq_max_size = open.max_size;
+    st.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    st.path = reconstruct_path(ctx.fwd.parent, s, t);
+    c.path_ns = phase.lap();
+    return st;
+}
+
+static Stats td_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure,
+                       SearchContext &ctx, bool astar) {
+    switch (ctx.queue) {
+        case QueueKind::Radix: return td_kernel(g, prof, s, t, departure, ctx, astar, ctx.fwd.radix);
+        case QueueKind::Dary: return td_kernel(g, prof, s, t, departure, ctx, astar, ctx.fwd.dary);
+        default: return td_kernel(g, prof, s, t, departure, ctx, astar, ctx.fwd.binary);
+    }
+}
+
+Stats td_dijkstra_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure, SearchContext &ctx) {
+    return td_search(g, prof, s, t, departure, ctx, false);
+}
+
+Stats td_dijkstra_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure) {
+    SearchContext ctx;
+    return td_dijkstra_search(g, prof, s, t, departure, ctx);
+}
+
+Stats td_astar_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure, SearchContext &ctx) {
+    return td_search(g, prof, s, t, departure, ctx, true);
+}
+
+Stats td_astar_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure) {
+    SearchContext ctx;
+    return td_astar_search(g, prof, s, t, departure, ctx);
+}
+
+/* Contraction Hierarchies query:
+   - Dijkstra forward from s over up_out and backward from t over up_in,
+     always expanding the side with the smaller queue key.
+   - Each side stops once its key reaches the best s-t distance seen.
+   - Shortcuts on the s-meet-t path are unpacked recursively.
+*/
+Stats ch_search(const ContractionHierarchy &ch, int s, int t, SearchContext &ctx) {
+    const int n = ch.num_nodes();
+    Stats st;
+    if (s<0||s>=n||t<0||t>=n) return st;
+    TraceScope trace("ch", s, t);
+    SearchCounters &c = st.counters;
+    PhaseClock phase;
+    const double INF = std::numeric_limits<double>::infinity();
+    ctx.prepare(n);
+    const auto &d_f = ctx.fwd.dist, &d_b = ctx.bwd.dist;
+    const auto &p_f = ctx.fwd.parent, &p_b = ctx.bwd.parent;
+    const auto &mid_f = ctx.fwd.aux, &mid_b = ctx.bwd.aux;
+    using PQ = std::pair<double,int>;
+    std::priority_queue<PQ, std::vector<PQ>, std::greater<PQ>> pq_f, pq_b;
+    ctx.fwd.set(s, 0.0, -1); pq_f.push({0.0, s});
+    ctx.bwd.set(t, 0.0, -1); pq_b.push({0.0, t});
+    st.pq_pushes = 2;
+    double best = INF;
+    int meet = -1;
+    size_t expanded = 0;
+    c.setup_ns = phase.lap();
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    while (true) {
+        bool fwd_open = !pq_f.empty() && pq_f.top().first < best;
+        bool bwd_open = !pq_b.empty() && pq_b.top().first < best;
+        if (!fwd_open && !bwd_open) break;
+        bool forward = fwd_open && (!bwd_open || pq_f.top().first <= pq_b.top().first);
+        auto &pq = forward ? pq_f : pq_b;
+        auto &side = forward ? ctx.fwd : ctx.bwd;
+        const auto &dist = side.dist;
+        const auto &other = forward ? d_b : d_f;
+        auto [d,u] = pq.top(); pq.pop();
+        if (d != dist[u]) { ROUTE_COUNT(c.stale_pops); continue; }
+        expanded++;
+        if (other[u] < INF && d + other[u] < best) { best = d + other[u]; meet = u; }
+        const CHEdge *b = forward ? ch.up_out_begin(u) : ch.up_in_begin(u);
+        const CHEdge *e = forward ? ch.up_out_end(u) : ch.up_in_end(u);
+        ROUTE_COUNT_N(c.relaxations, e - b);
+        for (; b != e; ++b) {
+            if (d + b->w < dist[b->to]) {
+                ROUTE_COUNT(c.improvements);
+                st.pq_pushes++;
+                side.set(b->to, d + b->w, u, b->mid);
+                pq.push({dist[b->to], b->to});
+            }
+        }
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    c.search_ns = phase.lap();
+    st.nodes_expanded = expanded;
+    st.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    st.distance = best;
+    if (meet < 0) return st;
+
+    std::vector<int> up_chain; // meet, ..., s
+    for (int cur = meet; cur != -1; cur = p_f[cur]) up_chain.push_back(cur);
+    std::reverse(up_chain.begin(), up_chain.end());
+    st.path.push_back(s);
+    for (size_t i = 1; i < up_chain.size(); ++i)
+        ch.unpack_edge(up_chain[i-1], up_chain[i], mid_f[up_chain[i]], st.path);
+    for (int cur = meet; p_b[cur] != -1; cur = p_b[cur])
+        ch.unpack_edge(cur, p_b[cur], mid_b[cur], st.path);
+    c.path_ns = phase.lap();
     return st;
 }
+
+Stats ch_search(const ContractionHierarchy &ch, int s, int t) {
+    SearchContext ctx;
+    return ch_search(ch, s, t, ctx);
+}
+
+/* One-to-many Dijkstra. The backward side of the context is otherwise
+   unused here, so it marks the targets: dist 0 for a pending target,
+   closed once it has been settled. The search stops when none are left.
+*/
+template <typename Queue>
+static size_t one_to_many_kernel(const Graph &g, int s, const std::vector<int> &targets, SearchContext &ctx,
+                                 Queue &pq, double *row) {
+    const int n = g.num_nodes();
+    const double INF = std::numeric_limits<double>::infinity();
+    std::fill(row, row + targets.size(), INF);
+    if (s<0||s>=n) return 0;
+    ctx.prepare(n);
+    auto &dist = ctx.fwd.dist;
+    auto &pending = ctx.bwd;
+    size_t remaining = 0;
+    for (int t : targets) {
+        if (t<0||t>=n||pending.dist[t] == 0.0) continue;
+        pending.set(t, 0.0, -1);
+        remaining++;
+    }
+    ctx.fwd.set(s, 0.0, -1);
+    pq.push(0.0, s);
+    size_t expanded = 0;
+    while (remaining > 0 && !pq.empty()) {
+        auto [d,u] = pq.pop();
+        if (d != dist[u]) continue; // stale
+        expanded++;
+        if (pending.dist[u] == 0.0 && !pending.closed[u]) {
+            pending.closed[u] = 1;
+            if (--remaining == 0) break;
+        }
+        for (const auto &e : g.neighbors(u, ctx.metric)) {
+            if (d + e.w < dist[e.to]) {
+                ctx.fwd.set(e.to, d + e.w, u);
+                pq.push(dist[e.to], e.to);
+            }
+        }
+    }
+    for (size_t j = 0; j < targets.size(); ++j)
+        if (targets[j] >= 0 && targets[j] < n) row[j] = dist[targets[j]];
+    return expanded;
+}
+
+static size_t one_to_many_row(const Graph &g, int s, const std::vector<int> &targets, SearchContext &ctx, double *row) {
+    switch (ctx.queue) {
+        case QueueKind::Radix: return one_to_many_kernel(g, s, targets, ctx, ctx.fwd.radix, row);
+        case QueueKind::Dary: return one_to_many_kernel(g, s, targets, ctx, ctx.fwd.dary, row);
+        default: return one_to_many_kernel(g, s, targets, ctx, ctx.fwd.binary, row);
+    }
+}
+
+DistanceMatrix one_to_many(const Graph &g, int s, const std::vector<int> &targets, SearchContext &ctx) {
+    DistanceMatrix m;
+    m.sources = {s};
+    m.targets = targets;
+    m.dist.resize(targets.size());
+    auto t0 = std::chrono::high_resolution_clock::now();
+    m.nodes_expanded = one_to_many_row(g, s, targets, ctx, m.dist.data());
+    auto t1 = std::chrono::high_resolution_clock::now();
+    m.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    return m;
+}
+
+DistanceMatrix one_to_many(const Graph &g, int s, const std::vector<int> &targets) {
+    SearchContext ctx;
+    return one_to_many(g, s, targets, ctx);
+}
+
+DistanceMatrix many_to_many(const Graph &g, const std::vector<int> &sources, const std::vector<int> &targets, int threads, int metric) {
+    DistanceMatrix m;
+    m.sources = sources;
+    m.targets = targets;
+    m.dist.resize(sources.size() * targets.size());
+    auto t0 = std::chrono::high_resolution_clock::now();
+    ThreadPool pool(threads > 0 ? threads : default_threads());
+    std::vector<SearchContext> contexts(pool.size());
+    for (auto &ctx : contexts) ctx.metric = metric;
+    std::vector<size_t> expanded(sources.size(), 0);
+    pool.for_each((int)sources.size(), 4, [&](int i, int worker) {
+        expanded[i] = one_to_many_row(g, sources[i], targets, contexts[worker], m.dist.data() + (size_t)i * targets.size());
+    });
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (size_t e : expanded) m.nodes_expanded += e;
+    m.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    return m;
+}
+
+// relax lanes du + w into dv (K lanes each); returns the smallest lane value that improved, INF if none
+#if defined(__GNUC__)
+#ifdef __AVX__
+typedef double lane_vec __attribute__((vector_size(32), aligned(8)));
+#else
+typedef double lane_vec __attribute__((vector_size(16), aligned(8)));
+#endif
+template <int K>
+static inline double relax_lanes(const double *du, double *dv, double w) {
+    constexpr int W = sizeof(lane_vec) / sizeof(double);
+    static_assert(K % W == 0, "lane count must be a multiple of the vector width");
+    const lane_vec inf = lane_vec{} + std::numeric_limits<double>::infinity();
+    lane_vec best = inf;
+    for (int l = 0; l < K; l += W) {
+        lane_vec c = *reinterpret_cast<const lane_vec*>(du + l) + w;
+        lane_vec old = *reinterpret_cast<const lane_vec*>(dv + l);
+        auto better = c < old;
+        *reinterpret_cast<lane_vec*>(dv + l) = better ? c : old;
+        lane_vec gain = better ? c : inf;
+        best = gain < best ? gain : best;
+    }
+    double m = best[0];
+    for (int i = 1; i < W; ++i) m = std::min(m, best[i]);
+    return m;
+}
+#else
+template <int K>
+static inline double relax_lanes(const double *du, double *dv, double w) {
+    double best = std::numeric_limits<double>::infinity();
+    for (int l = 0; l < K; ++l) {
+        double c = du[l] + w;
+        if (c < dv[l]) { dv[l] = c; best = std::min(best, c); }
+    }
+    return best;
+}
+#endif
+
+/* Multi-source lanes: node v keeps K distances in lanes[v*K .. v*K+K), one
+   per source, and sits in the queue under the smallest lane value that
+   improved since v was last scanned (pending, kept in ctx.fwd.dist). A
+   scan relaxes all K lanes of every edge at once with packed add / compare
+   / select (GCC vector extensions: SSE2, or AVX when enabled). Lanes whose
+   fronts reach a node together share its scan; a lane that improves after
+   the scan queues the node again, so every lane ends exact. Keys never
+   decrease (an improved lane value is at least the popped key), which the
+   radix queue relies on.
+   With targets, the search stops once the popped key reaches every
+   target's largest lane value: all values up to the key are final.
+*/
+template <int K, typename Queue>
+static size_t lanes_kernel(const Graph &g, const int *sources, int count, bool backward, const std::vector<int> *targets,
+                           SearchContext &ctx, Queue &pq) {
+    const int n = g.num_nodes();
+    const double INF = std::numeric_limits<double>::infinity();
+    ctx.prepare(n);
+    auto &lanes = ctx.lanes;
+    lanes.assign((size_t)n * K, INF);
+    auto &pending = ctx.fwd.dist;
+    for (int i = 0; i < count; ++i) {
+        int s = sources[i];
+        if (s < 0 || s >= n) continue;
+        lanes[(size_t)s * K + i] = 0.0;
+        if (pending[s] != 0.0) { ctx.fwd.set(s, 0.0, -1); pq.push(0.0, s); }
+    }
+    auto targets_done = [&](double key) {
+        for (int t : *targets) {
+            if (t < 0 || t >= n) continue;
+            const double *dt = &lanes[(size_t)t * K];
+            for (int l = 0; l < count; ++l) if (dt[l] > key) return false;
+        }
+        return true;
+    };
+    size_t scans = 0;
+    while (!pq.empty()) {
+        auto [key, u] = pq.pop();
+        if (key != pending[u]) continue; // stale
+        if (targets && (scans & 255) == 0 && targets_done(key)) break;
+        pending[u] = INF;
+        scans++;
+        const double *du = &lanes[(size_t)u * K];
+        for (const auto &e : backward ? g.in_neighbors(u, ctx.metric) : g.neighbors(u, ctx.metric)) {
+            double improved = relax_lanes<K>(du, &lanes[(size_t)e.to * K], e.w);
+            if (improved < pending[e.to]) {
+                ctx.fwd.set(e.to, improved, u);
+                pq.push(improved, e.to);
+            }
+        }
+    }
+    return scans;
+}
+
+template <int K>
+static size_t lanes_search(const Graph &g, const int *sources, int count, bool backward, const std::vector<int> *targets,
+                           SearchContext &ctx) {
+    switch (ctx.queue) {
+        case QueueKind::Radix: return lanes_kernel<K>(g, sources, count, backward, targets, ctx, ctx.fwd.radix);
+        case QueueKind::Dary: return lanes_kernel<K>(g, sources, count, backward, targets, ctx, ctx.fwd.dary);
+        default: return lanes_kernel<K>(g, sources, count, backward, targets, ctx, ctx.fwd.binary);
+    }
+}
+
+// one block of at most `lanes` sources; lane l of node v ends up in ctx.lanes[v * stride + l]
+static size_t lanes_block(const Graph &g, const int *sources, int count, int lanes, bool backward,
+                          const std::vector<int> *targets, SearchContext &ctx, int &stride) {
+    if (lanes <= 4 && count <= 4) { stride = 4; return lanes_search<4>(g, sources, count, backward, targets, ctx); }
+    if (lanes <= 8 && count <= 8) { stride = 8; return lanes_search<8>(g, sources, count, backward, targets, ctx); }
+    stride = 16;
+    return lanes_search<16>(g, sources, count, backward, targets, ctx);
+}
+
+static int lane_width(int lanes) { return lanes <= 4 ? 4 : lanes <= 8 ? 8 : 16; }
+
+size_t multi_source_dijkstra(const Graph &g, const std::vector<int> &sources, std::vector<double> &dist,
+                             SearchContext &ctx, int lanes, bool backward) {
+    const int n = g.num_nodes();
+    const size_t k = sources.size();
+    const int width = lane_width(lanes);
+    dist.assign((size_t)n * k, std::numeric_limits<double>::infinity());
+    size_t scans = 0;
+    for (size_t b = 0; b < k; b += width) {
+        int count = (int)std::min(k - b, (size_t)width), stride;
+        scans += lanes_block(g, sources.data() + b, count, width, backward, nullptr, ctx, stride);
+        for (int v = 0; v < n; ++v)
+            std::copy(&ctx.lanes[(size_t)v * stride], &ctx.lanes[(size_t)v * stride] + count, &dist[(size_t)v * k + b]);
+    }
+    return scans;
+}
+
+size_t multi_source_dijkstra(const Graph &g, const std::vector<int> &sources, std::vector<double> &dist, int lanes, bool backward) {
+    SearchContext ctx;
+    return multi_source_dijkstra(g, sources, dist, ctx, lanes, backward);
+}
+
+DistanceMatrix many_to_many_lanes(const Graph &g, const std::vector<int> &sources, const std::vector<int> &targets,
+                                  int threads, int metric, int lanes) {
+    DistanceMatrix m;
+    m.sources = sources;
+    m.targets = targets;
+    m.dist.assign(sources.size() * targets.size(), std::numeric_limits<double>::infinity());
+    auto t0 = std::chrono::high_resolution_clock::now();
+    const int width = lane_width(lanes);
+    const int blocks = (int)((sources.size() + width - 1) / width);
+    ThreadPool pool(threads > 0 ? threads : default_threads());
+    std::vector<SearchContext> contexts(pool.size());
+    for (auto &ctx : contexts) ctx.metric = metric;
+    // blocks of sources that are close together share most of their scans
+    const std::vector<int> order = hilbert_sort(g, sources);
+    std::vector<size_t> scans(blocks, 0);
+    pool.for_each(blocks, 1, [&](int b, int worker) {
+        SearchContext &ctx = contexts[worker];
+        const size_t first = (size_t)b * width;
+        int count = (int)std::min(sources.size() - first, (size_t)width), stride;
+        int block[16];
+        for (int l = 0; l < count; ++l) block[l] = sources[order[first + l]];
+        scans[b] = lanes_block(g, block, count, width, false, &targets, ctx, stride);
+        for (size_t j = 0; j < targets.size(); ++j) {
+            int t = targets[j];
+            if (t < 0 || t >= g.num_nodes()) continue;
+            for (int l = 0; l < count; ++l) m.dist[order[first + l] * targets.size() + j] = ctx.lanes[(size_t)t * stride + l];
+        }
+    });
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (size_t e : scans) m.nodes_expanded += e;
+    m.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    return m;
+}
+
+// exhaustive upward search from root (forward: up_out, backward: up_in); visit(u, d) per settled node
+template <typename Visit>
+static size_t ch_upward_search(const ContractionHierarchy &ch, int root, bool forward, SearchContext::Side &side, Visit visit) {
+    auto &pq = side.binary;
+    side.set(root, 0.0, -1);
+    pq.push(0.0, root);
+    size_t expanded = 0;
+    while (!pq.empty()) {
+        auto [d,u] = pq.pop();
+        if (d != side.dist[u]) continue; // stale
+        expanded++;
+        visit(u, d);
+        const CHEdge *b = forward ? ch.up_out_begin(u) : ch.up_in_begin(u);
+        const CHEdge *e = forward ? ch.up_out_end(u) : ch.up_in_end(u);
+        for (; b != e; ++b) {
+            if (d + b->w < side.dist[b->to]) {
+                side.set(b->to, d + b->w, u);
+                pq.push(d + b->w, b->to);
+            }
+        }
+    }
+    return expanded;
+}
+
+DistanceMatrix many_to_many(const ContractionHierarchy &ch, const std::vector<int> &sources, const std::vector<int> &targets, int threads) {
+    const int n = ch.num_nodes();
+    const double INF = std::numeric_limits<double>::infinity();
+    DistanceMatrix m;
+    m.sources = sources;
+    m.targets = targets;
+    m.dist.assign(sources.size() * targets.size(), INF);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    ThreadPool pool(threads > 0 ? threads : default_threads());
+    std::vector<SearchContext> contexts(pool.size());
+
+    // backward phase: bucket entries (column, distance up to the node), grouped per node in CSR form
+    struct Entry { int node; int col; double d; };
+    std::vector<Entry> entries;
+    for (size_t j = 0; j < targets.size(); ++j) {
+        int t = targets[j];
+        if (t<0||t>=n) continue;
+        contexts[0].prepare(n);
+        m.nodes_expanded += ch_upward_search(ch, t, false, contexts[0].bwd, [&](int u, double d) {
+            entries.push_back({u, (int)j, d});
+        });
+    }
+    std::vector<size_t> bucket_offsets(n + 1, 0);
+    for (const auto &e : entries) bucket_offsets[e.node + 1]++;
+    for (int u = 0; u < n; ++u) bucket_offsets[u+1] += bucket_offsets[u];
+    std::vector<std::pair<int,double>> buckets(entries.size());
+    {
+        std::vector<size_t> fill(bucket_offsets.begin(), bucket_offsets.end() - 1);
+        for (const auto &e : entries) buckets[fill[e.node]++] = {e.col, e.d};
+    }
+    entries.clear();
+    entries.shrink_to_fit();
+
+    // forward phase: rows are independent, buckets are read-only
+    std::vector<size_t> expanded(sources.size(), 0);
+    pool.for_each((int)sources.size(), 4, [&](int i, int worker) {
+        int s = sources[i];
+        if (s<0||s>=n) return;
+        double *row = m.dist.data() + (size_t)i * targets.size();
+        auto &ctx = contexts[worker];
+        ctx.prepare(n);
+        expanded[i] = ch_upward_search(ch, s, true, ctx.fwd, [&](int u, double d) {
+            for (size_t k = bucket_offsets[u]; k < bucket_offsets[u+1]; ++k) {
+                double &cell = row[buckets[k].first];
+                if (d + buckets[k].second < cell) cell = d + buckets[k].second;
+            }
+        });
+    });
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (size_t e : expanded) m.nodes_expanded += e;
+    m.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+    return m;
+}
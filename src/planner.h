@@ -2,18 +2,143 @@
 #define PLANNER_H
 
 #include "graph.h"
+#include "ch.h"
+#include "landmarks.h"
+#include "time_profiles.h"
+#include "search_context.h"
+#include "instrumentation.h"
 #include <vector>
 
 struct Stats {
     double distance = 0.0;
     size_t nodes_expanded = 0;
     long long millis = 0;
+    size_t pq_pushes = 0;    // priority-queue inserts (and decrease-keys)
+    size_t pq_max_size = 0;  // peak number of queued entries
+    SearchCounters counters; // all zero unless built with ROUTE_INSTRUMENT
     std::vector<int> path;
 };
 
+// great-circle distance in km between two (lat, lon) points in degrees (bidirectional A* potential)
+double haversine_km(double lat1, double lon1, double lat2, double lon2);
+// s -> t path from a parent array (-1 = none), empty when t was not reached from s
+std::vector<int> reconstruct_path(const std::vector<int> &parent, int s, int t);
+
 // algorithms
+// Overloads taking a SearchContext reuse its arrays across queries and use
+// the priority queue and edge metric selected by ctx.queue / ctx.metric; the
+// plain ones build a fresh context (O(n) allocation, binary heap, metric 0)
+// per call.
 Stats dijkstra_search(const Graph &g, int s, int t);
-Stats astar_search(const Graph &g, int s, int t);
-Stats bidir_astar_search(const Graph &g, int s, int t);
+Stats dijkstra_search(const Graph &g, int s, int t, SearchContext &ctx);
+// A* variants use the ALT landmark bound when lm is given, non-empty and
+// built for ctx.metric (Landmarks::metric())
+Stats astar_search(const Graph &g, int s, int t, const Landmarks *lm = nullptr);
+Stats astar_search(const Graph &g, int s, int t, SearchContext &ctx, const Landmarks *lm = nullptr);
+// bidirectional A* with averaged potentials: the ALT bound when lm is given,
+// otherwise haversine_km scaled by Graph::geo_scale(). The backward search
+// follows Graph::in_neighbors().
+Stats bidir_astar_search(const Graph &g, int s, int t, const Landmarks *lm = nullptr);
+Stats bidir_astar_search(const Graph &g, int s, int t, SearchContext &ctx, const Landmarks *lm = nullptr);
+// bidirectional Dijkstra (same engine, zero potential)
+Stats bidir_dijkstra_search(const Graph &g, int s, int t);
+Stats bidir_dijkstra_search(const Graph &g, int s, int t, SearchContext &ctx);
+// time-dependent earliest arrival leaving s at `departure` (time units of the
+// profiles): an edge entered at time T costs prof.travel_time(edge, T), and
+// Stats::distance is the travel time arrival - departure. Exact under FIFO.
+// Edges use prof.metric(), not ctx.metric; returns an empty Stats when prof
+// was built for another graph version.
+Stats td_dijkstra_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure);
+Stats td_dijkstra_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure, SearchContext &ctx);
+// same with haversine_km scaled by prof.geo_scale() as the A* bound
+Stats td_astar_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure);
+Stats td_astar_search(const Graph &g, const TravelTimeProfiles &prof, int s, int t, double departure, SearchContext &ctx);
+class ThreadPool;
+
+// range (isochrone) query: every node within `budget` of a source
+struct FrontierEdge {
+    int u, v;          // u in range, v beyond the budget
+    double fraction;   // part of u->v still within the budget, in [0, 1)
+};
+struct RangeResult {
+    int source = -1;
+    double budget = 0.0;
+    int metric = 0;
+    std::vector<int> nodes;              // reached nodes (distance <= budget) in settle order, source first
+    std::vector<double> dist;            // dist[i] belongs to nodes[i]
+    std::vector<FrontierEdge> frontier;  // edges leaving the range (closed edges excluded)
+    long long millis = 0;                // wall time in microseconds, like Stats::millis
+};
+// Dijkstra from s that stops at the first node beyond budget; uses ctx.metric and ctx.queue
+// and touches only the nodes it reaches (plus their neighbours), so small ranges stay cheap
+RangeResult range_search(const Graph &g, int s, double budget, SearchContext &ctx);
+RangeResult range_search(const Graph &g, int s, double budget, int metric = 0);
+
+// every node's distance and parent from one source
+struct ShortestPathTree {
+    std::vector<double> dist;  // INF when unreachable
+    std::vector<int> parent;   // -1 for the source and unreachable nodes
+    size_t settled = 0;        // reached nodes (Dijkstra) / node scans, rescans included (delta-stepping)
+    size_t relaxations = 0;    // delta-stepping: edge relaxations, light and heavy
+    size_t buckets = 0, phases = 0;  // delta-stepping: non-empty buckets and light phases
+    double delta = 0.0;        // delta-stepping: bucket width used
+    long long millis = 0;      // wall time in microseconds, like Stats::millis
+};
+// sequential reference: dijkstra_search run until the queue is empty
+ShortestPathTree dijkstra_tree(const Graph &g, int s, int metric = 0);
+ShortestPathTree dijkstra_tree(const Graph &g, int s, SearchContext &ctx);
+/* Parallel delta-stepping (Meyer & Sanders): nodes sit in buckets of width
+   delta by tentative distance; the lowest bucket is settled in light phases
+   that relax edges of weight <= delta from all its nodes at once (re-filling
+   the bucket until it stays empty), then its heavy edges are relaxed once.
+   Each phase is spread over the pool's workers; distances improve through
+   compare-and-swap, and every worker files improved nodes in its own
+   buckets. delta <= 0 picks the mean edge weight. Parents are repaired after
+   the search where racing improvements left them stale, so dist and parent
+   match dijkstra_tree (ties may pick another parent of equal distance). */
+ShortestPathTree delta_stepping(const Graph &g, int s, ThreadPool &pool, double delta = 0.0, int metric = 0);
+ShortestPathTree delta_stepping(const Graph &g, int s, int threads = 0, double delta = 0.0, int metric = 0);
+
+// bidirectional upward search on a prebuilt hierarchy; path is unpacked to original nodes.
+// Uses the metric the hierarchy was built for, not ctx.metric.
+Stats ch_search(const ContractionHierarchy &ch, int s, int t);
+Stats ch_search(const ContractionHierarchy &ch, int s, int t, SearchContext &ctx);
+
+// dense distance matrix: row i is sources[i], column j is targets[j]; INF when unreachable
+struct DistanceMatrix {
+    std::vector<int> sources, targets;
+    std::vector<double> dist;   // row-major, sources.size() x targets.size()
+    size_t nodes_expanded = 0;  // summed over all searches
+    long long millis = 0;       // wall time in microseconds, like Stats::millis
+    double at(size_t i, size_t j) const { return dist[i * targets.size() + j]; }
+};
+
+// one Dijkstra from s that stops once every target is settled (single-row matrix)
+DistanceMatrix one_to_many(const Graph &g, int s, const std::vector<int> &targets);
+DistanceMatrix one_to_many(const Graph &g, int s, const std::vector<int> &targets, SearchContext &ctx);
+// one-to-many per source, rows spread over `threads` workers (<= 0: all cores)
+DistanceMatrix many_to_many(const Graph &g, const std::vector<int> &sources, const std::vector<int> &targets, int threads = 0,
+                            int metric = 0);
+
+/* Batched full searches: blocks of `lanes` sources (4, 8 or 16) run as one
+   search whose nodes keep a distance per source side by side, so one pass
+   over a node's edges relaxes every lane with packed min / compare. It pays
+   off when the sources' search fronts overlap (sources close together
+   compared to the extent of the graph); far-apart sources rescan nodes
+   once per lane. dist[v * sources.size() + i] is the distance from
+   sources[i] to v (from v to sources[i], along in_neighbors(), when
+   backward). Uses ctx.metric and ctx.queue; returns the node scans. */
+size_t multi_source_dijkstra(const Graph &g, const std::vector<int> &sources, std::vector<double> &dist,
+                             int lanes = 8, bool backward = false);
+size_t multi_source_dijkstra(const Graph &g, const std::vector<int> &sources, std::vector<double> &dist,
+                             SearchContext &ctx, int lanes = 8, bool backward = false);
+// many_to_many with one multi-source search per block of `lanes` sources (grouped
+// along a Hilbert curve, so each block is as compact as the sources allow),
+// blocks spread over `threads`
+DistanceMatrix many_to_many_lanes(const Graph &g, const std::vector<int> &sources, const std::vector<int> &targets,
+                                  int threads = 0, int metric = 0, int lanes = 8);
+// bucket-based many-to-many on a hierarchy: one backward upward search per
+// target fills per-node buckets, one forward upward search per source scans them
+DistanceMatrix many_to_many(const ContractionHierarchy &ch, const std::vector<int> &sources, const std::vector<int> &targets, int threads = 0);
 
 #endif // PLANNER_H
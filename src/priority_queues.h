@@ -0,0 +1,200 @@
+#ifndef PRIORITY_QUEUES_H
+#define PRIORITY_QUEUES_H
+
+#include <vector>
+#include <string>
+#include <utility>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+
+/* Priority queues for the search kernels (see planner.cpp).
+   All of them share one interface so the kernels can be instantiated per
+   queue type:
+     clear(), empty(), size(), push(key, node), top_key(), pop() -> (key, node)
+   plus `pushes` / `max_size` counters that clear() resets.
+   Lazy queues may return stale entries; the kernels already skip those.
+*/
+
+enum class QueueKind { Binary, Radix, Dary };
+
+inline const char* queue_kind_name(QueueKind k) {
+    switch (k) {
+        case QueueKind::Radix: return "radix";
+        case QueueKind::Dary: return "dary";
+        default: return "binary";
+    }
+}
+
+inline bool parse_queue_kind(const std::string &s, QueueKind &out) {
+    if (s == "binary") { out = QueueKind::Binary; return true; }
+    if (s == "radix") { out = QueueKind::Radix; return true; }
+    if (s == "dary" || s == "4ary") { out = QueueKind::Dary; return true; }
+    return false;
+}
+
+// binary heap with lazy deletion (what std::priority_queue did), storage reused across queries
+class BinaryHeapQueue {
+public:
+    size_t pushes = 0, max_size = 0;
+
+    void clear() { heap.clear(); pushes = 0; max_size = 0; }
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    void push(double key, int v) {
+        heap.push_back({key, v});
+        std::push_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        ++pushes;
+        if (heap.size() > max_size) max_size = heap.size();
+    }
+    double top_key() const { return heap.front().first; }
+    std::pair<double,int> pop() {
+        std::pop_heap(heap.begin(), heap.end(), std::greater<Entry>());
+        Entry e = heap.back();
+        heap.pop_back();
+        return e;
+    }
+
+private:
+    using Entry = std::pair<double,int>;
+    std::vector<Entry> heap;
+};
+
+/* Monotone radix heap over the bit pattern of non-negative doubles (which
+   orders like the doubles themselves). Pushes cost O(1) and each entry
+   moves down at most 64 buckets in total. Keys below the last popped key
+   are clamped to it, which only happens with an inconsistent heuristic.
+*/
+class RadixHeapQueue {
+public:
+    size_t pushes = 0, max_size = 0;
+
+    void clear() {
+        for (auto &b : buckets) b.clear();
+        last = 0; count = 0; pushes = 0; max_size = 0;
+    }
+    bool empty() const { return count == 0; }
+    size_t size() const { return count; }
+    void push(double key, int v) {
+        uint64_t k = std::max(to_bits(key), last);
+        buckets[bucket_of(k)].push_back({k, v});
+        ++count; ++pushes;
+        if (count > max_size) max_size = count;
+    }
+    double top_key() { refill(); return from_bits(buckets[0].back().first); }
+    std::pair<double,int> pop() {
+        refill();
+        auto e = buckets[0].back();
+        buckets[0].pop_back();
+        --count;
+        return {from_bits(e.first), e.second};
+    }
+
+private:
+    std::vector<std::pair<uint64_t,int>> buckets[65];
+    uint64_t last = 0;
+    size_t count = 0;
+
+    static uint64_t to_bits(double key) {
+        if (!(key > 0.0)) return 0;
+        uint64_t b; std::memcpy(&b, &key, 8); return b;
+    }
+    static double from_bits(uint64_t b) { double d; std::memcpy(&d, &b, 8); return d; }
+    int bucket_of(uint64_t k) const { return k == last ? 0 : 64 - __builtin_clzll(k ^ last); }
+
+    // make bucket 0 non-empty: redistribute the first non-empty bucket around its minimum
+    void refill() {
+        if (!buckets[0].empty()) return;
+        int i = 1;
+        while (buckets[i].empty()) ++i;
+        uint64_t m = buckets[i][0].first;
+        for (const auto &e : buckets[i]) m = std::min(m, e.first);
+        last = m;
+        for (const auto &e : buckets[i]) buckets[bucket_of(e.first)].push_back(e);
+        buckets[i].clear();
+    }
+};
+
+/* D-ary heap with a node -> slot index, supporting decrease-key, so every
+   node is in the heap at most once and no stale entries are ever popped.
+   The index grows to the largest node id seen and is reset through the
+   remaining entries on clear().
+*/
+template <int D>
+class IndexedDaryHeap {
+public:
+    size_t pushes = 0, max_size = 0;
+
+    void clear() {
+        for (const auto &e : heap) pos[e.second] = -1;
+        heap.clear();
+        pushes = 0; max_size = 0;
+    }
+    bool empty() const { return heap.empty(); }
+    size_t size() const { return heap.size(); }
+    // insert v, or lower its key if it is already queued
+    void push(double key, int v) {
+        if (v >= (int)pos.size()) pos.resize(v + 1, -1);
+        int i = pos[v];
+        if (i >= 0) {
+            if (key >= heap[i].first) return;
+            heap[i].first = key;
+        } else {
+            i = (int)heap.size();
+            heap.push_back({key, v});
+            pos[v] = i;
+        }
+        ++pushes;
+        if (heap.size() > max_size) max_size = heap.size();
+        sift_up(i);
+    }
+    double top_key() const { return heap[0].first; }
+    std::pair<double,int> pop() {
+        auto top = heap[0];
+        pos[top.second] = -1;
+        auto last = heap.back();
+        heap.pop_back();
+        if (!heap.empty()) {
+            heap[0] = last;
+            pos[last.second] = 0;
+            sift_down(0);
+        }
+        return top;
+    }
+
+private:
+    std::vector<std::pair<double,int>> heap;
+    std::vector<int> pos;
+
+    void place(int i, const std::pair<double,int> &e) { heap[i] = e; pos[e.second] = i; }
+    void sift_up(int i) {
+        auto e = heap[i];
+        while (i > 0) {
+            int p = (i - 1) / D;
+            if (heap[p].first <= e.first) break;
+            place(i, heap[p]);
+            i = p;
+        }
+        place(i, e);
+    }
+    void sift_down(int i) {
+        auto e = heap[i];
+        const int n = (int)heap.size();
+        while (true) {
+            int c = i * D + 1;
+            if (c >= n) break;
+            int best = c;
+            int end = std::min(c + D, n);
+            for (int j = c + 1; j < end; ++j) if (heap[j].first < heap[best].first) best = j;
+            if (heap[best].first >= e.first) break;
+            place(i, heap[best]);
+            i = best;
+        }
+        place(i, e);
+    }
+};
+
+using FourAryHeapQueue = IndexedDaryHeap<4>;
+
+#endif // PRIORITY_QUEUES_H
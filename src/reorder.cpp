@@ -0,0 +1,147 @@
+// Node renumbering for memory locality (Graph::reorder).
+// Nodes that are close in the road network end up close in the coords,
+// CSR and per-query dist/parent arrays, so a search touches fewer cache
+// lines and pages.
+#include "graph.h"
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+
+const char* node_order_name(NodeOrder o) {
+    switch (o) {
+        case NodeOrder::Hilbert: return "hilbert";
+        case NodeOrder::Bfs: return "bfs";
+        default: return "input";
+    }
+}
+
+bool parse_node_order(const std::string &s, NodeOrder &out) {
+    if (s == "input" || s == "none") { out = NodeOrder::Input; return true; }
+    if (s == "hilbert") { out = NodeOrder::Hilbert; return true; }
+    if (s == "bfs" || s == "cm") { out = NodeOrder::Bfs; return true; }
+    return false;
+}
+
+namespace {
+
+// position of (x, y) along a Hilbert curve over a 2^16 x 2^16 grid
+uint64_t hilbert_index(uint32_t x, uint32_t y) {
+    uint64_t d = 0;
+    for (uint32_t s = 1u << 15; s > 0; s >>= 1) {
+        uint32_t rx = (x & s) ? 1 : 0;
+        uint32_t ry = (y & s) ? 1 : 0;
+        d += (uint64_t)s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) { x = 65535 - x; y = 65535 - y; }
+            std::swap(x, y);
+        }
+    }
+    return d;
+}
+
+} // namespace
+
+std::vector<int> hilbert_sort(const Graph &g, const std::vector<int> &nodes) {
+    const int n = g.num_nodes();
+    const auto coords = g.get_coords();
+    std::vector<int> order(nodes.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (n == 0) return order;
+    double lat0 = coords[0].first, lat1 = lat0, lon0 = coords[0].second, lon1 = lon0;
+    for (int u = 0; u < n; ++u) {
+        lat0 = std::min(lat0, coords[u].first); lat1 = std::max(lat1, coords[u].first);
+        lon0 = std::min(lon0, coords[u].second); lon1 = std::max(lon1, coords[u].second);
+    }
+    auto cell = [](double v, double lo, double hi) {
+        if (!(hi > lo)) return 0u;
+        return (uint32_t)std::min(65535.0, (v - lo) / (hi - lo) * 65535.0);
+    };
+    std::vector<uint64_t> key(nodes.size());
+    for (size_t i = 0; i < nodes.size(); ++i) {
+        int u = nodes[i];
+        key[i] = u < 0 || u >= n ? UINT64_MAX
+                                 : hilbert_index(cell(coords[u].second, lon0, lon1), cell(coords[u].first, lat0, lat1));
+    }
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return key[a] < key[b]; });
+    return order;
+}
+
+namespace {
+
+std::vector<int> hilbert_order(const Graph &g) {
+    std::vector<int> all(g.num_nodes());
+    std::iota(all.begin(), all.end(), 0);
+    return hilbert_sort(g, all);
+}
+
+// Cuthill-McKee: BFS from a low-degree node per component, neighbours by increasing degree
+std::vector<int> bfs_order(const Graph &g) {
+    const int n = g.num_nodes();
+    std::vector<int> seeds(n);
+    std::iota(seeds.begin(), seeds.end(), 0);
+    std::stable_sort(seeds.begin(), seeds.end(), [&](int a, int b) { return g.degree(a) < g.degree(b); });
+    std::vector<char> seen(n, 0);
+    std::vector<int> order;
+    order.reserve(n);
+    std::vector<int> next;
+    for (int seed : seeds) {
+        if (seen[seed]) continue;
+        seen[seed] = 1;
+        order.push_back(seed);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            next.clear();
+            for (const auto &e : g.neighbors(order[head]))
+                if (!seen[e.to]) { seen[e.to] = 1; next.push_back(e.to); }
+            std::stable_sort(next.begin(), next.end(), [&](int a, int b) { return g.degree(a) < g.degree(b); });
+            order.insert(order.end(), next.begin(), next.end());
+        }
+    }
+    return order;
+}
+
+} // namespace
+
+void Graph::reorder(NodeOrder order_kind) {
+    if (order_kind == NodeOrder::Input || n_ == 0) return;
+    std::vector<int> order = order_kind == NodeOrder::Hilbert ? hilbert_order(*this) : bfs_order(*this); // new -> old
+    make_owned();
+    const int n = n_;
+    std::vector<int> new_id(n);
+    for (int i = 0; i < n; ++i) new_id[order[i]] = i;
+
+    std::vector<std::pair<double,double>> new_coords(n);
+    std::vector<std::string> new_names(n);
+    std::vector<int> new_offsets(n + 1, 0);
+    std::vector<int> new_targets(m_);
+    std::vector<weight_t> new_weights(m_);
+    std::vector<std::vector<uint32_t>> new_q(extra_metrics.size(), std::vector<uint32_t>(m_));
+    for (int i = 0; i < n; ++i) {
+        int old = order[i];
+        new_coords[i] = coords[old];
+        new_names[i] = std::move(names[old]);
+        int pos = new_offsets[i];
+        for (int k = offsets[old]; k < offsets[old+1]; ++k, ++pos) {
+            new_targets[pos] = new_id[targets[k]];
+            new_weights[pos] = weights[k];
+            for (size_t j = 0; j < extra_metrics.size(); ++j) new_q[j][pos] = extra_metrics[j].q[k];
+        }
+        new_offsets[i+1] = pos;
+    }
+
+    // compose with an earlier renumbering so external ids stay those of the input
+    std::vector<int> ext(n);
+    for (int i = 0; i < n; ++i) ext[i] = to_external(order[i]);
+    external_ids = std::move(ext);
+    internal_ids.assign(n, -1);
+    for (int i = 0; i < n; ++i) internal_ids[external_ids[i]] = i;
+
+    coords.swap(new_coords);
+    names.swap(new_names);
+    offsets.swap(new_offsets);
+    targets.swap(new_targets);
+    weights.swap(new_weights);
+    for (size_t j = 0; j < extra_metrics.size(); ++j) extra_metrics[j].q.swap(new_q[j]);
+    sync_views();
+    build_reverse();
+    bump_version();
+}
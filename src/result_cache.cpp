@@ -0,0 +1,68 @@
+#include "result_cache.h"
+#include <algorithm>
+
+size_t ResultCache::KeyHash::operator()(const CacheKey &k) const {
+    uint64_t h = (uint64_t)(uint32_t)k.source * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)(uint32_t)k.target + 0x7F4A7C159E3779B9ULL + (h << 6) + (h >> 2);
+    h ^= (uint64_t)(uint32_t)k.algorithm + (h << 6) + (h >> 2);
+    h ^= k.graph_version + (h << 6) + (h >> 2);
+    return (size_t)(h ^ (h >> 29));
+}
+
+ResultCache::ResultCache(size_t capacity, int num_shards) {
+    num_shards = std::max(1, num_shards);
+    // small caches use fewer shards so every shard keeps a useful number of entries
+    while (num_shards > 1 && capacity / num_shards < 16) num_shards /= 2;
+    shard_capacity = std::max<size_t>(1, capacity / num_shards);
+    for (int i = 0; i < num_shards; ++i) shards.push_back(std::make_unique<Shard>());
+}
+
+bool ResultCache::get(const CacheKey &key, Stats &out) {
+    Shard &s = shard_of(key);
+    std::lock_guard<std::mutex> lock(s.mu);
+    auto it = s.index.find(key);
+    if (it == s.index.end()) { s.misses++; return false; }
+    s.lru.splice(s.lru.begin(), s.lru, it->second);
+    out = it->second->second;
+    s.hits++;
+    return true;
+}
+
+void ResultCache::put(const CacheKey &key, const Stats &st) {
+    Shard &s = shard_of(key);
+    std::lock_guard<std::mutex> lock(s.mu);
+    auto it = s.index.find(key);
+    if (it != s.index.end()) {
+        it->second->second = st;
+        s.lru.splice(s.lru.begin(), s.lru, it->second);
+        return;
+    }
+    s.lru.emplace_front(key, st);
+    s.index[key] = s.lru.begin();
+    if (s.lru.size() > shard_capacity) {
+        s.index.erase(s.lru.back().first);
+        s.lru.pop_back();
+        s.evictions++;
+    }
+}
+
+void ResultCache::clear() {
+    for (auto &s : shards) {
+        std::lock_guard<std::mutex> lock(s->mu);
+        s->lru.clear();
+        s->index.clear();
+        s->hits = s->misses = s->evictions = 0;
+    }
+}
+
+CacheCounters ResultCache::counters() const {
+    CacheCounters c;
+    for (const auto &s : shards) {
+        std::lock_guard<std::mutex> lock(s->mu);
+        c.hits += s->hits;
+        c.misses += s->misses;
+        c.evictions += s->evictions;
+        c.size += s->lru.size();
+    }
+    return c;
+}
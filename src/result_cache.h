@@ -0,0 +1,76 @@
+#ifndef RESULT_CACHE_H
+#define RESULT_CACHE_H
+
+#include "planner.h"
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <chrono>
+
+// query identity; graph_version (Graph::version()) keeps results of an older graph from being served
+struct CacheKey {
+    int source, target;
+    int algorithm;            // caller-defined algorithm id
+    uint64_t graph_version;
+    bool operator==(const CacheKey &o) const {
+        return source == o.source && target == o.target && algorithm == o.algorithm && graph_version == o.graph_version;
+    }
+};
+
+struct CacheCounters {
+    size_t hits = 0, misses = 0, evictions = 0, size = 0;
+    double hit_rate() const { return hits + misses ? (double)hits / (hits + misses) : 0.0; }
+};
+
+/* Bounded LRU cache of query results (distance + path), safe to share
+   between threads. Keys are spread over independently locked shards, each
+   an LRU list plus hash index holding capacity/shards entries, so workers
+   rarely contend on the same lock.
+*/
+class ResultCache {
+public:
+    explicit ResultCache(size_t capacity, int shards = 16);
+
+    // copies the cached result into out and marks it most recently used
+    bool get(const CacheKey &key, Stats &out);
+    void put(const CacheKey &key, const Stats &st);
+    void clear();
+    CacheCounters counters() const;
+    size_t capacity() const { return shard_capacity * shards.size(); }
+
+private:
+    struct KeyHash { size_t operator()(const CacheKey &k) const; };
+    struct Shard {
+        mutable std::mutex mu;
+        std::list<std::pair<CacheKey, Stats>> lru; // front = most recently used
+        std::unordered_map<CacheKey, std::list<std::pair<CacheKey, Stats>>::iterator, KeyHash> index;
+        size_t hits = 0, misses = 0, evictions = 0;
+    };
+    size_t shard_capacity;
+    std::vector<std::unique_ptr<Shard>> shards;
+
+    Shard& shard_of(const CacheKey &key) { return *shards[KeyHash()(key) % shards.size()]; }
+};
+
+// run() unless key is cached (cache may be null); a hit reports no expanded nodes and the lookup time
+template <typename Fn>
+Stats cached_query(ResultCache *cache, const CacheKey &key, Fn run) {
+    if (!cache) return run();
+    Stats st;
+    auto t0 = std::chrono::high_resolution_clock::now();
+    if (cache->get(key, st)) {
+        auto t1 = std::chrono::high_resolution_clock::now();
+        st.nodes_expanded = 0;
+        st.pq_pushes = st.pq_max_size = 0;
+        st.millis = std::chrono::duration_cast<std::chrono::microseconds>(t1 - t0).count();
+        return st;
+    }
+    st = run();
+    cache->put(key, st);
+    return st;
+}
+
+#endif // RESULT_CACHE_H
@@ -0,0 +1,744 @@
+// route_bench.cpp
+// microbenchmarks of the hot paths on synthetic graphs, reported like Google Benchmark
+#include "graph.h"
+#include "planner.h"
+#include "io.h"
+#include "isochrone.h"
+#include "parallel.h"
+#include "spatial_index.h"
+#include "synthetic.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <chrono>
+#include <ctime>
+#include <queue>
+#include <limits>
+#include <functional>
+#include <filesystem>
+#include <thread>
+#include <algorithm>
+#include <random>
+#include <cmath>
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/* Benchmark harness
+   Every benchmark is a function that performs State::iterations repetitions
+   of the measured operation. The runner warms up, grows the iteration count
+   until one run lasts at least --min-time ms, then times --repetitions runs
+   of that many iterations and reports mean/median/stddev/min/max and the
+   coefficient of variation of the per-iteration time. --json writes the
+   runs and aggregates in Google Benchmark's JSON layout, so existing tools
+   (compare.py, python/compare_bench.py) can diff two result files.
+*/
+struct State {
+    size_t iterations = 1;
+    std::map<std::string, double> counters; // totals over the run, reported per iteration
+    double bytes = 0;                        // total bytes processed, reported as bytes_per_second
+};
+
+struct Benchmark {
+    std::string name;
+    std::function<void(State&)> run;
+    size_t batch = 1;  // iteration counts are rounded to a multiple, e.g. whole passes over the query pairs
+};
+
+struct Run {
+    size_t iterations;
+    double real_ns, cpu_ns;                  // per iteration
+    std::map<std::string, double> counters;  // per iteration, plus bytes_per_second
+};
+
+struct Options {
+    double min_time_ms = 200;
+    double warmup_ms = 50;
+    int repetitions = 5;
+    std::string filter;
+};
+
+// keeps results alive so the optimizer cannot drop the measured work
+static volatile double sink;
+static void keep(double v) { sink = sink + v; }
+
+static Run time_run(const Benchmark &b, size_t iterations) {
+    State st;
+    st.iterations = iterations;
+    std::clock_t c0 = std::clock();
+    auto t0 = std::chrono::steady_clock::now();
+    b.run(st);
+    auto t1 = std::chrono::steady_clock::now();
+    std::clock_t c1 = std::clock();
+    Run r;
+    r.iterations = iterations;
+    double real = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    r.real_ns = real / iterations;
+    r.cpu_ns = (double)(c1 - c0) / CLOCKS_PER_SEC * 1e9 / iterations;
+    for (const auto &c : st.counters) r.counters[c.first] = c.second / iterations;
+    if (st.bytes > 0 && real > 0) r.counters["bytes_per_second"] = st.bytes / (real / 1e9);
+    return r;
+}
+
+static std::vector<Run> run_benchmark(const Benchmark &b, const Options &opt) {
+    // warmup: touch the code and data paths, then keep running until warmup_ms has passed
+    auto w0 = std::chrono::steady_clock::now();
+    do time_run(b, 1);
+    while (std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - w0).count() < opt.warmup_ms);
+
+    // calibrate like Google Benchmark: grow the count until a run takes min_time
+    size_t iters = 1;
+    for (;;) {
+        Run r = time_run(b, iters);
+        double ms = r.real_ns * iters / 1e6;
+        if (ms >= opt.min_time_ms || iters >= 1000000000) break;
+        double grow = ms > 0 ? 1.4 * opt.min_time_ms / ms : 10.0;
+        iters = std::max(iters + 1, (size_t)(iters * std::min(10.0, std::max(grow, 1.0))));
+    }
+    // benchmarks cycling over inputs measure the same inputs whatever the calibration picked
+    if (b.batch > 1) iters = (iters + b.batch - 1) / b.batch * b.batch;
+    std::vector<Run> runs;
+    for (int i = 0; i < opt.repetitions; ++i) runs.push_back(time_run(b, iters));
+    return runs;
+}
+
+struct Summary {
+    double mean, median, stddev, min, max, cv;
+};
+
+static Summary summarize(std::vector<double> v) {
+    Summary s{};
+    if (v.empty()) return s;
+    std::sort(v.begin(), v.end());
+    double sum = 0;
+    for (double x : v) sum += x;
+    s.mean = sum / v.size();
+    s.median = v.size() % 2 ? v[v.size()/2] : (v[v.size()/2 - 1] + v[v.size()/2]) / 2;
+    double sq = 0;
+    for (double x : v) sq += (x - s.mean) * (x - s.mean);
+    s.stddev = v.size() > 1 ? std::sqrt(sq / (v.size() - 1)) : 0.0;
+    s.min = v.front();
+    s.max = v.back();
+    s.cv = s.mean > 0 ? s.stddev / s.mean : 0.0;
+    return s;
+}
+
+// hardware cache misses of the calling thread; -1 where perf events are unavailable (containers, non-Linux)
+class CacheMissCounter {
+public:
+    CacheMissCounter() {
+#ifdef __linux__
+        perf_event_attr a{};
+        a.type = PERF_TYPE_HARDWARE;
+        a.size = sizeof(a);
+        a.config = PERF_COUNT_HW_CACHE_MISSES;
+        a.disabled = 1;
+        a.exclude_kernel = 1;
+        a.exclude_hv = 1;
+        fd = (int)syscall(__NR_perf_event_open, &a, 0, -1, -1, 0);
+#endif
+    }
+    ~CacheMissCounter() {
+#ifdef __linux__
+        if (fd >= 0) close(fd);
+#endif
+    }
+    void start() {
+#ifdef __linux__
+        if (fd >= 0) { ioctl(fd, PERF_EVENT_IOC_RESET, 0); ioctl(fd, PERF_EVENT_IOC_ENABLE, 0); }
+#endif
+    }
+    long long stop() {
+        long long v = -1;
+#ifdef __linux__
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd, &v, sizeof(v)) != sizeof(v)) v = -1;
+        }
+#endif
+        return v;
+    }
+private:
+    int fd = -1;
+};
+
+// full single-source Dijkstra over any adjacency accessor, used to compare layouts
+template <typename NeighborsFn>
+static double sssp_sum(int n, int s, NeighborsFn neighbors, std::vector<int> *parent = nullptr) {
+    const double INF = std::numeric_limits<double>::infinity();
+    std::vector<double> dist(n, INF);
+    if (parent) parent->assign(n, -1);
+    using PQ = std::pair<double,int>;
+    std::priority_queue<PQ, std::vector<PQ>, std::greater<PQ>> pq;
+    dist[s] = 0.0;
+    pq.push({0.0, s});
+    while (!pq.empty()) {
+        auto [d,u] = pq.top(); pq.pop();
+        if (d != dist[u]) continue;
+        for (const auto &e : neighbors(u)) {
+            if (d + e.w < dist[e.to]) {
+                dist[e.to] = d + e.w;
+                if (parent) (*parent)[e.to] = u;
+                pq.push({dist[e.to], e.to});
+            }
+        }
+    }
+    double sum = 0.0;
+    for (double d : dist) if (d < INF) sum += d;
+    return sum;
+}
+
+/* Per-graph inputs shared by the benchmarks of one synthetic graph. Query
+   pairs, snap points and heuristic targets are drawn once from a fixed seed
+   so every run (and every commit) measures the same work. */
+struct Fixture {
+    std::string kind;
+    Graph g;
+    std::vector<std::pair<int,int>> pairs;
+    std::vector<std::pair<double,double>> points;
+    std::vector<std::vector<Edge>> nested;
+    Landmarks lm;
+    SpatialIndex index;
+    std::vector<int> parent;   // shortest-path tree of node 0, for path reconstruction
+    std::vector<int> far;      // nodes ordered far-to-near from node 0
+    std::string nodes_csv, edges_csv, snapshot;
+    double csv_bytes = 0, snapshot_bytes = 0;
+    std::unique_ptr<ContractionHierarchy> ch;
+    TravelTimeProfiles profiles;  // synthetic rush-hour profiles on every edge
+    // (source, its farthest reachable node) for batched full searches:
+    // 8 random sources, and 8 neighbouring ones
+    std::vector<std::pair<int,int>> spread, near;
+    std::vector<std::vector<int>> routes;  // tree paths to the `far` nodes, for the route writers
+    std::string routes_out;                // scratch file the writers overwrite
+};
+
+static std::unique_ptr<Fixture> make_fixture(SyntheticKind kind, int size, int queries, bool with_ch,
+                                             const std::string &tmpdir) {
+    auto f = std::make_unique<Fixture>();
+    f->kind = synthetic_kind_name(kind);
+    SyntheticOptions so;
+    so.kind = kind;
+    so.nodes = size;
+    f->g = make_synthetic_graph(so);
+    const Graph &g = f->g;
+    const int n = g.num_nodes();
+
+    std::mt19937 rng(12345);
+    std::uniform_int_distribution<int> node(0, n-1);
+    f->pairs.resize(queries);
+    for (auto &p : f->pairs) p = {node(rng), node(rng)};
+    double lat0 = 90, lat1 = -90, lon0 = 180, lon1 = -180;
+    for (const auto &c : g.get_coords()) {
+        lat0 = std::min(lat0, c.first); lat1 = std::max(lat1, c.first);
+        lon0 = std::min(lon0, c.second); lon1 = std::max(lon1, c.second);
+    }
+    std::uniform_real_distribution<double> lat(lat0, lat1), lon(lon0, lon1);
+    f->points.resize(queries);
+    for (auto &p : f->points) p = {lat(rng), lon(rng)};
+
+    f->nested.resize(n);
+    for (int u = 0; u < n; ++u)
+        for (const auto &e : g.neighbors(u)) f->nested[u].push_back(e);
+    f->lm.build(g, 8);
+    f->index.build(g);
+    sssp_sum(n, 0, [&](int u) { return g.neighbors(u); }, &f->parent);
+    // the deepest tree nodes give the longest (worst-case) reconstructions
+    std::vector<int> depth(n, -1);
+    for (int v = 0; v < n; ++v) depth[v] = (int)reconstruct_path(f->parent, 0, v).size();
+    f->far.resize(n);
+    for (int v = 0; v < n; ++v) f->far[v] = v;
+    std::sort(f->far.begin(), f->far.end(), [&](int a, int b) { return depth[a] > depth[b]; });
+    f->far.resize(std::min(n, 64));
+    for (int v : f->far) f->routes.push_back(reconstruct_path(f->parent, 0, v));
+
+    f->nodes_csv = tmpdir + "/" + f->kind + "_nodes.csv";
+    f->edges_csv = tmpdir + "/" + f->kind + "_edges.csv";
+    f->snapshot = tmpdir + "/" + f->kind + ".rpg";
+    f->routes_out = tmpdir + "/" + f->kind + "_routes.geojson";
+    write_graph_csv(g, f->nodes_csv, f->edges_csv);
+    g.save_snapshot(f->snapshot);
+    std::error_code ec;
+    f->csv_bytes = (double)(std::filesystem::file_size(f->nodes_csv, ec) + std::filesystem::file_size(f->edges_csv, ec));
+    f->snapshot_bytes = (double)std::filesystem::file_size(f->snapshot, ec);
+    f->profiles.build(g, make_synthetic_profiles(g));
+
+    std::vector<int> spread, near{f->pairs[0].first};
+    for (int i = 0; i < 8; ++i) spread.push_back(node(rng));
+    std::vector<char> seen(n, 0);
+    seen[near[0]] = 1;
+    for (size_t h = 0; h < near.size() && near.size() < 8; ++h)  // breadth-first from the first one
+        for (const auto &e : g.neighbors(near[h]))
+            if (!seen[e.to] && near.size() < 8) { seen[e.to] = 1; near.push_back(e.to); }
+    for (auto sources : {&spread, &near}) {
+        std::vector<double> dist;
+        multi_source_dijkstra(g, *sources, dist);
+        auto &out = sources == &spread ? f->spread : f->near;
+        const size_t k = sources->size();
+        for (size_t i = 0; i < k; ++i) {
+            int far = (*sources)[i];
+            for (int v = 0; v < n; ++v)
+                if (std::isfinite(dist[v*k+i]) && dist[v*k+i] > dist[far*k+i]) far = v;
+            out.push_back({(*sources)[i], far});
+        }
+    }
+    if (with_ch) {
+        f->ch = std::make_unique<ContractionHierarchy>();
+        f->ch->build(g);
+    }
+    return f;
+}
+
+// point-to-point queries cycling over the fixture's pairs; counters are search effort per query
+static void add_search(std::vector<Benchmark> &out, const Fixture &f, const std::string &name,
+                       QueueKind queue, std::function<Stats(int,int,SearchContext&)> search) {
+    out.push_back({f.kind + "/search/" + name, [&f, queue, search](State &st) {
+        SearchContext ctx;
+        ctx.queue = queue;
+        size_t k = 0;
+        for (size_t i = 0; i < st.iterations; ++i) {
+            const auto &p = f.pairs[k];
+            if (++k == f.pairs.size()) k = 0;
+            Stats s = search(p.first, p.second, ctx);
+            keep(s.distance);
+            st.counters["nodes_expanded"] += s.nodes_expanded;
+            st.counters["pq_pushes"] += s.pq_pushes;
+            if (instrumentation_enabled) {
+                st.counters["relaxations"] += s.counters.relaxations;
+                st.counters["stale_pops"] += s.counters.stale_pops;
+                st.counters["heuristic_evals"] += s.counters.heuristic_evals;
+            }
+        }
+    }});
+    out.back().batch = f.pairs.size();
+}
+
+static void add_benchmarks(std::vector<Benchmark> &out, const Fixture &f) {
+    const Graph &g = f.g;
+    // CSV parsing on one thread and on every core
+    std::vector<int> load_threads = {1};
+    if (default_threads() > 1) load_threads.push_back(default_threads());
+    for (int threads : load_threads) {
+        out.push_back({f.kind + "/load/csv_t" + std::to_string(threads), [&f, threads](State &st) {
+            for (size_t i = 0; i < st.iterations; ++i) {
+                Graph h;
+                h.load_nodes_csv(f.nodes_csv, threads);
+                h.load_edges_csv(f.edges_csv, true, threads);
+                keep(h.num_edges());
+            }
+            st.bytes = f.csv_bytes * st.iterations;
+        }});
+    }
+    out.push_back({f.kind + "/load/snapshot", [&f](State &st) {
+        for (size_t i = 0; i < st.iterations; ++i) {
+            Graph h;
+            h.load_snapshot(f.snapshot, true);
+            keep(h.num_edges());
+        }
+        st.bytes = f.snapshot_bytes * st.iterations;
+    }});
+
+    // route output: the previous ofstream writer against the buffered stream, all `far` routes per iteration
+    out.push_back({f.kind + "/io/routes_ofstream", [&f](State &st) {
+        const auto coords = f.g.get_coords();
+        for (size_t i = 0; i < st.iterations; ++i) {
+            std::ofstream os(f.routes_out);
+            os << std::fixed << std::setprecision(7) << "{ \"type\": \"FeatureCollection\", \"features\": [\n";
+            for (size_t r = 0; r < f.routes.size(); ++r) {
+                const auto &path = f.routes[r];
+                os << (r ? ",\n" : "") << "{ \"type\":\"Feature\", \"geometry\": { \"type\":\"LineString\", \"coordinates\": [";
+                for (size_t j = 0; j < path.size(); ++j)
+                    os << (j ? ", [" : "[") << coords[path[j]].second << ", " << coords[path[j]].first << "]";
+                os << "] }, \"properties\": { \"label\": \"tree\", \"distance\": " << std::setprecision(10) << std::defaultfloat
+                   << (double)path.size() << ", \"nodes\": " << path.size() << ", \"source\": " << f.g.to_external(path.front())
+                   << ", \"target\": " << f.g.to_external(path.back()) << " } }" << std::fixed << std::setprecision(7);
+            }
+            os << "\n] }\n";
+            st.bytes += (double)os.tellp();
+        }
+    }});
+    for (double tolerance : {0.0, 0.05}) {
+        out.push_back({f.kind + "/io/routes_stream" + (tolerance > 0 ? "_simplified" : ""), [&f, tolerance](State &st) {
+            for (size_t i = 0; i < st.iterations; ++i) {
+                GeoJsonRouteStream os(f.routes_out, tolerance);
+                for (const auto &path : f.routes) os.add(f.g, path, "tree", (double)path.size());
+                os.close();
+                st.bytes += (double)os.bytes();
+                st.counters["vertices"] += os.vertices();
+            }
+        }});
+    }
+    out.push_back({f.kind + "/io/metrics_csv", [&f](State &st) {
+        std::vector<std::pair<std::string, Stats>> rows(f.routes.size());
+        for (size_t r = 0; r < rows.size(); ++r) {
+            rows[r].first = "route" + std::to_string(r);
+            rows[r].second.path = f.routes[r];
+            rows[r].second.distance = f.routes[r].size() * 0.1;
+        }
+        std::error_code ec;
+        for (size_t i = 0; i < st.iterations; ++i) {
+            write_metrics_csv(f.routes_out, rows);
+            st.bytes += (double)std::filesystem::file_size(f.routes_out, ec);
+        }
+    }});
+
+    for (QueueKind q : {QueueKind::Binary, QueueKind::Radix, QueueKind::Dary})
+        add_search(out, f, std::string("dijkstra/") + queue_kind_name(q), q,
+                   [&g](int s, int t, SearchContext &ctx) { return dijkstra_search(g, s, t, ctx); });
+    add_search(out, f, "astar", QueueKind::Binary,
+               [&g](int s, int t, SearchContext &ctx) { return astar_search(g, s, t, ctx); });
+    add_search(out, f, "astar_alt", QueueKind::Binary,
+               [&f](int s, int t, SearchContext &ctx) { return astar_search(f.g, s, t, ctx, &f.lm); });
+    add_search(out, f, "bidir_dijkstra", QueueKind::Binary,
+               [&g](int s, int t, SearchContext &ctx) { return bidir_dijkstra_search(g, s, t, ctx); });
+    add_search(out, f, "bidir_astar", QueueKind::Binary,
+               [&g](int s, int t, SearchContext &ctx) { return bidir_astar_search(g, s, t, ctx); });
+    add_search(out, f, "bidir_astar_alt", QueueKind::Binary,
+               [&f](int s, int t, SearchContext &ctx) { return bidir_astar_search(f.g, s, t, ctx, &f.lm); });
+    // time-dependent queries leaving in the morning peak, against the static searches above
+    const double depart = 8 * 3600.0;
+    for (QueueKind q : {QueueKind::Binary, QueueKind::Radix})
+        add_search(out, f, std::string("td_dijkstra/") + queue_kind_name(q), q,
+                   [&f, depart](int s, int t, SearchContext &ctx) { return td_dijkstra_search(f.g, f.profiles, s, t, depart, ctx); });
+    add_search(out, f, "td_astar", QueueKind::Binary,
+               [&f, depart](int s, int t, SearchContext &ctx) { return td_astar_search(f.g, f.profiles, s, t, depart, ctx); });
+    if (f.ch)
+        add_search(out, f, "ch", QueueKind::Binary,
+                   [&f](int s, int t, SearchContext &ctx) { return ch_search(*f.ch, s, t, ctx); });
+
+    out.push_back({f.kind + "/heuristic/haversine", [&f](State &st) {
+        const auto coords = f.g.get_coords();
+        const int n = f.g.num_nodes();
+        const auto t = coords[f.far[0]];
+        double acc = 0;
+        int u = 0;
+        for (size_t i = 0; i < st.iterations; ++i) {
+            acc += haversine_km(coords[u].first, coords[u].second, t.first, t.second);
+            if (++u == n) u = 0;
+        }
+        keep(acc);
+    }});
+    out.back().batch = (size_t)f.g.num_nodes();
+    out.push_back({f.kind + "/heuristic/alt_lower_bound", [&f](State &st) {
+        const int n = f.g.num_nodes(), t = f.far[0];
+        double acc = 0;
+        int u = 0;
+        for (size_t i = 0; i < st.iterations; ++i) {
+            acc += f.lm.lower_bound(u, t);
+            if (++u == n) u = 0;
+        }
+        keep(acc);
+    }});
+    out.back().batch = (size_t)f.g.num_nodes();
+    // cost of one edge weight: interpolated profile vs the static array
+    out.push_back({f.kind + "/profile/travel_time", [&f](State &st) {
+        const auto w = f.g.edge_weights();
+        const size_t m = w.size();
+        double acc = 0, t = 0;
+        size_t i = 0;
+        for (size_t k = 0; k < st.iterations; ++k) {
+            acc += f.profiles.travel_time(i, t, w[i]);
+            if (++i == m) i = 0;
+            t += 7.0;
+        }
+        keep(acc);
+        st.counters["profile_bytes"] = (double)f.profiles.bytes() * st.iterations;
+    }});
+    out.back().batch = f.g.num_edges();
+    out.push_back({f.kind + "/path/reconstruct", [&f](State &st) {
+        size_t k = 0;
+        for (size_t i = 0; i < st.iterations; ++i) {
+            auto path = reconstruct_path(f.parent, 0, f.far[k]);
+            if (++k == f.far.size()) k = 0;
+            keep(path.size());
+            st.counters["path_len"] += path.size();
+        }
+    }});
+    out.back().batch = f.far.size();
+    out.push_back({f.kind + "/snap/kd_tree", [&f](State &st) {
+        size_t k = 0;
+        for (size_t i = 0; i < st.iterations; ++i) {
+            const auto &p = f.points[k];
+            if (++k == f.points.size()) k = 0;
+            keep(f.index.nearest(p.first, p.second));
+        }
+    }});
+    out.back().batch = f.points.size();
+    out.push_back({f.kind + "/snap/brute_force", [&f](State &st) {
+        const auto coords = f.g.get_coords();
+        size_t k = 0;
+        for (size_t i = 0; i < st.iterations; ++i) {
+            const auto &p = f.points[k];
+            if (++k == f.points.size()) k = 0;
+            double best = std::numeric_limits<double>::infinity();
+            for (const auto &c : coords) best = std::min(best, haversine_km(p.first, p.second, c.first, c.second));
+            keep(best);
+        }
+    }});
+    out.back().batch = f.points.size();
+
+    // CSR vs vector<vector<Edge>> on full single-source searches
+    out.push_back({f.kind + "/layout/csr_sssp", [&f](State &st) {
+        const int n = f.g.num_nodes();
+        for (size_t i = 0; i < st.iterations; ++i)
+            keep(sssp_sum(n, (int)(i % n), [&](int u) { return f.g.neighbors(u); }));
+        st.counters["adjacency_bytes"] = (double)f.g.adjacency_bytes() * st.iterations;
+    }});
+    out.push_back({f.kind + "/layout/nested_sssp", [&f](State &st) {
+        const int n = f.g.num_nodes();
+        for (size_t i = 0; i < st.iterations; ++i)
+            keep(sssp_sum(n, (int)(i % n), [&](int u) -> const std::vector<Edge>& { return f.nested[u]; }));
+        size_t bytes = n * sizeof(std::vector<Edge>);
+        for (const auto &v : f.nested) bytes += v.capacity() * sizeof(Edge) + (v.capacity() ? 16 : 0); // + malloc header
+        st.counters["adjacency_bytes"] = (double)bytes * st.iterations;
+    }});
+
+    // full searches from 8 sources: 8 Dijkstras (each until its farthest node) against
+    // multi-source searches with 4 and 8 distance lanes per node
+    for (auto sources : {&f.spread, &f.near}) {
+        const std::string which = sources == &f.spread ? "spread" : "near";
+        out.push_back({f.kind + "/batch/" + which + "/dijkstra_x8", [&f, sources](State &st) {
+            SearchContext ctx;
+            for (size_t i = 0; i < st.iterations; ++i)
+                for (const auto &p : *sources) {
+                    Stats s = dijkstra_search(f.g, p.first, p.second, ctx);
+                    keep(s.distance);
+                    st.counters["nodes_expanded"] += s.nodes_expanded;
+                }
+        }});
+        for (int lanes : {4, 8})
+            out.push_back({f.kind + "/batch/" + which + "/lanes" + std::to_string(lanes), [&f, sources, lanes](State &st) {
+                SearchContext ctx;
+                std::vector<int> ids;
+                for (const auto &p : *sources) ids.push_back(p.first);
+                std::vector<double> dist;
+                for (size_t i = 0; i < st.iterations; ++i) {
+                    st.counters["nodes_expanded"] += multi_source_dijkstra(f.g, ids, dist, ctx, lanes);
+                    keep(dist[(size_t)sources->front().second * ids.size()]);
+                }
+            }});
+    }
+
+    // full shortest-path trees: sequential Dijkstra vs delta-stepping on one worker and on every core
+    out.push_back({f.kind + "/sssp/dijkstra_tree", [&f](State &st) {
+        SearchContext ctx;
+        for (size_t i = 0; i < st.iterations; ++i) {
+            ShortestPathTree t = dijkstra_tree(f.g, f.pairs[0].first, ctx);
+            keep(t.dist[f.pairs[0].second]);
+            st.counters["nodes_expanded"] += t.settled;
+        }
+    }});
+    std::vector<int> pool_sizes = {1};
+    if (default_threads() > 1) pool_sizes.push_back(default_threads());
+    for (int threads : pool_sizes) {
+        auto pool = std::make_shared<ThreadPool>(threads);
+        out.push_back({f.kind + "/sssp/delta_stepping_t" + std::to_string(threads), [&f, pool](State &st) {
+            for (size_t i = 0; i < st.iterations; ++i) {
+                ShortestPathTree t = delta_stepping(f.g, f.pairs[0].first, *pool);
+                keep(t.dist[f.pairs[0].second]);
+                st.counters["nodes_expanded"] += t.settled;
+                st.counters["phases"] += t.phases;
+            }
+        }});
+    }
+
+    // range queries with a quarter and all of the first pair's distance as budget, and the outline of each
+    double far = dijkstra_search(f.g, f.pairs[0].first, f.pairs[0].second).distance;
+    if (!std::isfinite(far)) far = 1.0;
+    for (double share : {0.25, 1.0}) {
+        const std::string which = share < 1 ? "quarter" : "full";
+        const double budget = share * far;
+        out.push_back({f.kind + "/range/" + which + "/search", [&f, budget](State &st) {
+            SearchContext ctx;
+            for (size_t i = 0; i < st.iterations; ++i) {
+                RangeResult r = range_search(f.g, f.pairs[0].first, budget, ctx);
+                keep(r.dist.back());
+                st.counters["nodes_expanded"] += r.nodes.size();
+            }
+        }});
+        auto range = std::make_shared<RangeResult>(range_search(f.g, f.pairs[0].first, budget));
+        out.push_back({f.kind + "/range/" + which + "/polygons", [&f, range](State &st) {
+            for (size_t i = 0; i < st.iterations; ++i) {
+                auto polys = range_polygons(f.g, *range);
+                keep(polys.size());
+                for (const auto &p : polys) st.counters["vertices"] += p[0].size();
+            }
+        }});
+    }
+
+    // node renumbering: Dijkstra over the same (input-id) pairs, with hardware cache misses when available
+    for (NodeOrder o : {NodeOrder::Input, NodeOrder::Hilbert, NodeOrder::Bfs}) {
+        auto h = std::make_shared<Graph>(f.g);
+        h->reorder(o);
+        out.push_back({f.kind + "/order/" + node_order_name(o) + "/dijkstra", [&f, h](State &st) {
+            SearchContext ctx;
+            CacheMissCounter misses;
+            misses.start();
+            size_t k = 0;
+            for (size_t i = 0; i < st.iterations; ++i) {
+                const auto &p = f.pairs[k];
+                if (++k == f.pairs.size()) k = 0;
+                keep(dijkstra_search(*h, h->to_internal(p.first), h->to_internal(p.second), ctx).distance);
+            }
+            long long cm = misses.stop();
+            if (cm >= 0) st.counters["cache_misses"] = (double)cm;
+        }});
+        out.back().batch = f.pairs.size();
+    }
+}
+
+static std::string json_escape(const std::string &s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+static void write_run_json(std::ostream &out, const std::string &name, const std::string &run_name,
+                           const char *run_type, const char *aggregate, int reps, int index,
+                           size_t iterations, double real_ns, double cpu_ns, const std::map<std::string, double> &counters) {
+    out << "    {\n      \"name\": \"" << json_escape(name) << "\",\n      \"run_name\": \"" << json_escape(run_name)
+        << "\",\n      \"run_type\": \"" << run_type << "\",\n      \"repetitions\": " << reps << ",\n";
+    if (aggregate) out << "      \"aggregate_name\": \"" << aggregate << "\",\n";
+    else out << "      \"repetition_index\": " << index << ",\n";
+    out << "      \"iterations\": " << iterations << ",\n      \"real_time\": " << real_ns
+        << ",\n      \"cpu_time\": " << cpu_ns << ",\n      \"time_unit\": \"ns\"";
+    for (const auto &c : counters) out << ",\n      \"" << json_escape(c.first) << "\": " << c.second;
+    out << "\n    }";
+}
+
+// value of `--name value` anywhere in argv, or def
+static std::string flag_value(int argc, char** argv, const std::string &name, const std::string &def) {
+    for (int i = 1; i+1 < argc; ++i) if (argv[i] == name) return argv[i+1];
+    return def;
+}
+
+static bool has_flag(int argc, char** argv, const std::string &name) {
+    for (int i = 1; i < argc; ++i) if (argv[i] == name) return true;
+    return false;
+}
+
+int main(int argc, char** argv) {
+    if (has_flag(argc, argv, "--help")) {
+        std::cout << "Usage: " << argv[0] << " [--size N] [--graphs grid,geometric,road] [--filter substr] [--queries Q]\n"
+                  << "       [--min-time ms] [--warmup ms] [--repetitions R] [--json out.json] [--no-ch] [--list]\n";
+        return 0;
+    }
+    Options opt;
+    int size = std::stoi(flag_value(argc, argv, "--size", "10000"));
+    int queries = std::max(1, std::stoi(flag_value(argc, argv, "--queries", "256")));
+    opt.min_time_ms = std::stod(flag_value(argc, argv, "--min-time", "200"));
+    opt.warmup_ms = std::stod(flag_value(argc, argv, "--warmup", std::to_string(opt.min_time_ms / 4)));
+    opt.repetitions = std::max(1, std::stoi(flag_value(argc, argv, "--repetitions", "5")));
+    opt.filter = flag_value(argc, argv, "--filter", "");
+    std::string json_path = flag_value(argc, argv, "--json", "");
+    // CH preprocessing dominates setup on large graphs; --no-ch skips it
+    bool with_ch = !has_flag(argc, argv, "--no-ch");
+    bool list_only = has_flag(argc, argv, "--list");
+
+    std::vector<SyntheticKind> kinds;
+    std::stringstream gs(flag_value(argc, argv, "--graphs", "grid,geometric,road"));
+    for (std::string item; std::getline(gs, item, ','); ) {
+        SyntheticKind k;
+        if (!parse_synthetic_kind(item, k)) { std::cerr << "Unknown graph kind: " << item << "\n"; return 1; }
+        kinds.push_back(k);
+    }
+
+    std::error_code ec;
+    std::string tmpdir = (std::filesystem::temp_directory_path(ec) / ("route_bench_" + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count()))).string();
+    std::filesystem::create_directories(tmpdir, ec);
+
+    std::vector<std::unique_ptr<Fixture>> fixtures;
+    std::vector<Benchmark> benches;
+    for (SyntheticKind k : kinds) {
+        auto f0 = std::chrono::steady_clock::now();
+        fixtures.push_back(make_fixture(k, size, queries, with_ch, tmpdir));
+        auto f1 = std::chrono::steady_clock::now();
+        const Fixture &f = *fixtures.back();
+        std::cerr << "Graph " << f.kind << ": nodes=" << f.g.num_nodes() << " edges=" << f.g.num_edges()
+                  << " (setup " << std::chrono::duration<double, std::milli>(f1 - f0).count() << " ms)\n";
+        add_benchmarks(benches, f);
+    }
+    benches.erase(std::remove_if(benches.begin(), benches.end(),
+                                 [&](const Benchmark &b) { return b.name.find(opt.filter) == std::string::npos; }),
+                  benches.end());
+    if (list_only) {
+        for (const auto &b : benches) std::cout << b.name << "\n";
+        std::filesystem::remove_all(tmpdir, ec);
+        return 0;
+    }
+
+    std::ostringstream json;
+    json << std::setprecision(10);
+    bool first_json = true;
+    auto json_sep = [&]() { if (!first_json) json << ",\n"; first_json = false; };
+
+    std::cout << std::left << std::setw(44) << "Benchmark" << std::right << std::setw(14) << "mean ns"
+              << std::setw(14) << "median ns" << std::setw(12) << "stddev" << std::setw(8) << "cv%"
+              << std::setw(12) << "iterations" << "  counters\n";
+    std::cout << std::string(118, '-') << "\n";
+    for (const auto &b : benches) {
+        std::vector<Run> runs = run_benchmark(b, opt);
+        std::vector<double> real, cpu;
+        std::map<std::string, std::vector<double>> counters;
+        for (size_t i = 0; i < runs.size(); ++i) {
+            real.push_back(runs[i].real_ns);
+            cpu.push_back(runs[i].cpu_ns);
+            for (const auto &c : runs[i].counters) counters[c.first].push_back(c.second);
+            json_sep();
+            write_run_json(json, b.name, b.name, "iteration", nullptr, opt.repetitions, (int)i,
+                           runs[i].iterations, runs[i].real_ns, runs[i].cpu_ns, runs[i].counters);
+        }
+        Summary sr = summarize(real), sc = summarize(cpu);
+        std::map<std::string, Summary> cs;
+        for (const auto &c : counters) cs[c.first] = summarize(c.second);
+        // aggregates in Google Benchmark order; counters are aggregated the same way as the times
+        const char *agg_names[] = {"mean", "median", "stddev", "cv", "min", "max"};
+        auto pick = [](const Summary &s, int k) {
+            double v[] = {s.mean, s.median, s.stddev, s.cv, s.min, s.max};
+            return v[k];
+        };
+        for (int k = 0; k < 6; ++k) {
+            std::map<std::string, double> agg;
+            for (const auto &c : cs) agg[c.first] = pick(c.second, k);
+            json_sep();
+            write_run_json(json, b.name + "_" + agg_names[k], b.name, "aggregate", agg_names[k], opt.repetitions, 0,
+                           runs[0].iterations, pick(sr, k), pick(sc, k), agg);
+        }
+
+        std::cout << std::left << std::setw(44) << b.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << sr.mean << std::setw(14) << sr.median << std::setw(12) << sr.stddev
+                  << std::setw(8) << sr.cv * 100 << std::setw(12) << runs[0].iterations << " ";
+        for (const auto &c : cs) {
+            if (c.first == "bytes_per_second") std::cout << " MB/s=" << c.second.mean / (1024.0*1024.0);
+            else std::cout << " " << c.first << "=" << c.second.mean;
+        }
+        std::cout << std::defaultfloat << std::setprecision(6) << "\n";
+    }
+    std::filesystem::remove_all(tmpdir, ec);
+
+    if (!json_path.empty()) {
+        std::ofstream out(json_path);
+        if (!out.is_open()) { std::cerr << "Failed to open " << json_path << "\n"; return 2; }
+        std::time_t now = std::time(nullptr);
+        char date[32];
+        std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+        out << "{\n  \"context\": {\n    \"date\": \"" << date << "\",\n    \"executable\": \"" << json_escape(argv[0])
+            << "\",\n    \"num_cpus\": " << std::max(1u, std::thread::hardware_concurrency())
+            << ",\n    \"library_build_type\": \"release\",\n    \"graph_size\": " << size
+            << ",\n    \"queries\": " << queries << ",\n    \"min_time_ms\": " << opt.min_time_ms
+            << ",\n    \"repetitions\": " << opt.repetitions
+            << "\n  },\n  \"benchmarks\": [\n" << json.str() << "\n  ]\n}\n";
+        std::cout << "Wrote " << json_path << "\n";
+    }
+    return 0;
+}
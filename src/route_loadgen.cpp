@@ -0,0 +1,153 @@
+// route_loadgen.cpp
+// load generator for route_server
+//   --print N            write N random request lines to stdout (pipe into route_server's stdin)
+//   --socket path        drive a server listening on a Unix socket and report latency/throughput
+#include <iostream>
+#include <string>
+#include <vector>
+#include <random>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// value of `--name value` anywhere in argv, or def
+static std::string flag_value(int argc, char** argv, const std::string &name, const std::string &def) {
+    for (int i = 1; i+1 < argc; ++i) if (argv[i] == name) return argv[i+1];
+    return def;
+}
+
+static int connect_unix(const std::string &path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) < 0) { close(fd); return -1; }
+    return fd;
+}
+
+static bool write_all(int fd, const std::string &s) {
+    size_t off = 0;
+    while (off < s.size()) {
+        ssize_t w = write(fd, s.data() + off, s.size() - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        off += w;
+    }
+    return true;
+}
+
+// reads exactly `count` response lines
+static bool read_lines(int fd, std::string &buf, int count, std::vector<std::string> &lines) {
+    lines.clear();
+    while ((int)lines.size() < count) {
+        size_t nl = buf.find('\n');
+        if (nl != std::string::npos) {
+            lines.push_back(buf.substr(0, nl));
+            buf.erase(0, nl + 1);
+            continue;
+        }
+        char tmp[65536];
+        ssize_t r = read(fd, tmp, sizeof(tmp));
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        buf.append(tmp, r);
+    }
+    return true;
+}
+
+static std::string request_line(std::mt19937 &rng, int nodes, const std::string &algo) {
+    std::uniform_int_distribution<int> node(0, nodes - 1);
+    std::string line = std::to_string(node(rng)) + " " + std::to_string(node(rng));
+    if (!algo.empty()) line += " " + algo;
+    return line + "\n";
+}
+
+int main(int argc, char** argv) {
+    int requests = std::stoi(flag_value(argc, argv, "--requests", "10000"));
+    int print = std::stoi(flag_value(argc, argv, "--print", "0"));
+    int connections = std::max(1, std::stoi(flag_value(argc, argv, "--connections", "4")));
+    int window = std::max(1, std::stoi(flag_value(argc, argv, "--window", "32")));
+    unsigned seed = (unsigned)std::stoul(flag_value(argc, argv, "--seed", "1"));
+    std::string algo = flag_value(argc, argv, "--algo", "");
+    std::string socket_path = flag_value(argc, argv, "--socket", "");
+    int nodes = std::stoi(flag_value(argc, argv, "--nodes", "0"));
+
+    if (print > 0) {
+        if (nodes <= 0) { std::cerr << "--print needs --nodes N\n"; return 1; }
+        std::mt19937 rng(seed);
+        for (int i = 0; i < print; ++i) std::cout << request_line(rng, nodes, algo);
+        return 0;
+    }
+    if (socket_path.empty()) {
+        std::cerr << "Usage: " << argv[0] << " --socket path [--requests N] [--connections C] [--window W] [--algo name] [--seed S]\n"
+                  << "       " << argv[0] << " --print N --nodes n [--algo name] [--seed S]\n";
+        return 1;
+    }
+
+    // ask the server for the graph size unless given
+    if (nodes <= 0) {
+        int fd = connect_unix(socket_path);
+        if (fd < 0) { std::cerr << "Cannot connect to " << socket_path << "\n"; return 2; }
+        std::string buf;
+        std::vector<std::string> lines;
+        if (!write_all(fd, "info\n") || !read_lines(fd, buf, 1, lines)) { std::cerr << "No reply to info\n"; return 2; }
+        close(fd);
+        size_t p = lines[0].find("\"nodes\":");
+        if (p != std::string::npos) nodes = std::stoi(lines[0].substr(p + 8));
+        if (nodes <= 0) { std::cerr << "Bad info reply: " << lines[0] << "\n"; return 2; }
+    }
+
+    // each connection keeps up to `window` requests in flight and timestamps every request
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<int> errors(connections, 0);
+    auto t0 = std::chrono::high_resolution_clock::now();
+    std::vector<std::thread> threads;
+    for (int c = 0; c < connections; ++c) {
+        threads.emplace_back([&, c]() {
+            int fd = connect_unix(socket_path);
+            if (fd < 0) { errors[c] = -1; return; }
+            std::mt19937 rng(seed + c);
+            int todo = requests / connections + (c < requests % connections ? 1 : 0);
+            std::string buf, out;
+            std::vector<std::string> lines;
+            while (todo > 0) {
+                int k = std::min(window, todo);
+                out.clear();
+                for (int i = 0; i < k; ++i) out += request_line(rng, nodes, algo);
+                auto s0 = std::chrono::high_resolution_clock::now();
+                if (!write_all(fd, out) || !read_lines(fd, buf, k, lines)) { errors[c] += todo; break; }
+                auto s1 = std::chrono::high_resolution_clock::now();
+                double us = std::chrono::duration<double, std::micro>(s1 - s0).count();
+                for (const auto &l : lines) {
+                    if (l.find("\"error\"") != std::string::npos) errors[c]++;
+                    latencies[c].push_back(us); // a window is answered as a whole
+                }
+                todo -= k;
+            }
+            close(fd);
+        });
+    }
+    for (auto &th : threads) th.join();
+    auto t1 = std::chrono::high_resolution_clock::now();
+
+    std::vector<double> all;
+    int errs = 0;
+    for (int c = 0; c < connections; ++c) {
+        all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        if (errors[c] < 0) { std::cerr << "Connection " << c << " failed\n"; errs += requests / connections; }
+        else errs += errors[c];
+    }
+    std::sort(all.begin(), all.end());
+    auto pct = [&](double p) { return all.empty() ? 0.0 : all[(size_t)(p / 100.0 * (all.size() - 1))]; };
+    double sec = std::chrono::duration<double>(t1 - t0).count();
+    std::cout << "requests=" << all.size() << " errors=" << errs << " connections=" << connections << " window=" << window << "\n";
+    std::cout << "throughput_qps=" << (sec > 0 ? all.size() / sec : 0.0) << " wall_ms=" << sec * 1000.0 << "\n";
+    std::cout << "latency_us p50=" << pct(50) << " p90=" << pct(90) << " p99=" << pct(99) << " max=" << pct(100) << "\n";
+    return errs ? 3 : 0;
+}
@@ -0,0 +1,369 @@
+// route_server.cpp
+// long-running query server: loads the graph (and CH / landmarks) once and
+// answers shortest-path requests, one per line, over stdin/stdout or a Unix
+// domain socket.
+//
+// Request:  <source> <target> [algorithm] [metric]   ids or lat,lon; algorithm defaults to ch,
+//                                                    metric to the one given by --metric
+//           info                            graph size, algorithm and metric names, cache counters
+//           update set|close|insert <u> <v> [w]   edge change on the default metric (graph_updates.h)
+// Response: one JSON object per line, in request order
+//
+// Requests that are already buffered when one is read form a batch that is
+// spread over the worker pool; the batch is answered with a single write.
+// Consecutive update lines in a batch are applied as one copy-on-write
+// version before the requests after them; requests before them, and those
+// in flight on other connections, finish on the version they started on.
+// Once the graph has changed, ch falls back to bidir_astar and the ALT
+// variants drop their landmarks if a weight went down.
+#include "graph.h"
+#include "planner.h"
+#include "io.h"
+#include "parallel.h"
+#include "spatial_index.h"
+#include "result_cache.h"
+#include "graph_updates.h"
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <chrono>
+#include <csignal>
+#include <cerrno>
+#include <cstdio>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+// value of `--name value` anywhere in argv, or def
+static std::string flag_value(int argc, char** argv, const std::string &name, const std::string &def) {
+    for (int i = 1; i+1 < argc; ++i) if (argv[i] == name) return argv[i+1];
+    return def;
+}
+
+static bool has_flag(int argc, char** argv, const std::string &name) {
+    for (int i = 1; i < argc; ++i) if (argv[i] == name) return true;
+    return false;
+}
+
+// "lat,lon" when the argument contains a comma, otherwise a node id
+static bool parse_lat_lon(const std::string &arg, double &lat, double &lon) {
+    size_t comma = arg.find(',');
+    if (comma == std::string::npos) return false;
+    lat = std::stod(arg.substr(0, comma));
+    lon = std::stod(arg.substr(comma + 1));
+    return true;
+}
+
+// line reader over a file descriptor that can tell which lines have already arrived
+class LineReader {
+public:
+    explicit LineReader(int fd): fd(fd) {}
+    // next line; with wait=false only returns a line that is available without blocking
+    bool next(std::string &line, bool wait) {
+        while (true) {
+            size_t nl = buf.find('\n', pos);
+            if (nl != std::string::npos) {
+                line.assign(buf, pos, nl - pos);
+                pos = nl + 1;
+                if (!line.empty() && line.back() == '\r') line.pop_back();
+                return true;
+            }
+            if (eof) {
+                if (pos >= buf.size()) return false;
+                line.assign(buf, pos, std::string::npos); // last line without a newline
+                pos = buf.size();
+                return true;
+            }
+            if (!wait) {
+                pollfd p{fd, POLLIN, 0};
+                if (poll(&p, 1, 0) <= 0) return false;
+            }
+            buf.erase(0, pos);
+            pos = 0;
+            char tmp[65536];
+            ssize_t r = read(fd, tmp, sizeof(tmp));
+            if (r < 0 && errno == EINTR) continue;
+            if (r <= 0) eof = true;
+            else buf.append(tmp, r);
+        }
+    }
+private:
+    int fd;
+    std::string buf;
+    size_t pos = 0;
+    bool eof = false;
+};
+
+static bool write_all(int fd, const std::string &s) {
+    size_t off = 0;
+    while (off < s.size()) {
+        ssize_t w = write(fd, s.data() + off, s.size() - off);
+        if (w < 0 && errno == EINTR) continue;
+        if (w <= 0) return false;
+        off += w;
+    }
+    return true;
+}
+
+static std::string json_escape(const std::string &s) {
+    std::string out;
+    for (char c : s) {
+        if (c == '"' || c == '\\') out += '\\';
+        if ((unsigned char)c < 0x20) continue;
+        out += c;
+    }
+    return out;
+}
+
+struct Server {
+    GraphVersions versions;
+    SpatialIndex snap;
+    std::map<std::string, std::function<Stats(const Graph&,int,int,SearchContext&)>> algos;
+    std::string default_algo;
+    int metric = 0;         // default metric, and the one CH / landmarks were built for
+    uint64_t ch_version = 0; // graph version the hierarchy was contracted on
+    bool with_path = true;
+    size_t max_batch = 256;
+    std::unique_ptr<ResultCache> cache; // null unless --cache N
+
+    ThreadPool pool;
+    std::vector<SearchContext> contexts;
+    std::mutex pool_mu; // ThreadPool runs one job at a time; connections take turns
+
+    Server(Graph g, int threads): versions(std::move(g)), pool(threads), contexts(pool.size()) {}
+
+    int resolve(const Graph &g, const std::string &arg) {
+        double lat, lon;
+        if (parse_lat_lon(arg, lat, lon)) return snap.nearest(lat, lon);
+        int id = std::stoi(arg);
+        return (id >= 0 && id < g.num_nodes()) ? g.to_internal(id) : -1;
+    }
+
+    std::string info() const {
+        auto cur = versions.current();
+        const Graph &g = *cur;
+        std::ostringstream out;
+        out << "{\"nodes\":" << g.num_nodes() << ",\"edges\":" << g.num_edges() << ",\"algorithms\":[";
+        bool first = true;
+        for (const auto &a : algos) { out << (first ? "" : ",") << "\"" << a.first << "\""; first = false; }
+        out << "],\"default\":\"" << default_algo << "\",\"metrics\":[";
+        for (int k = 0; k < g.num_metrics(); ++k) out << (k ? "," : "") << "\"" << json_escape(g.metric_name(k)) << "\"";
+        out << "],\"default_metric\":\"" << json_escape(g.metric_name(metric)) << "\",\"directed\":" << (g.is_directed() ? "true" : "false")
+            << ",\"version\":" << g.version() << ",\"updated\":" << (g.version() != ch_version ? "true" : "false");
+        if (cache) {
+            CacheCounters c = cache->counters();
+            out << ",\"cache\":{\"size\":" << c.size << ",\"capacity\":" << cache->capacity() << ",\"hits\":" << c.hits
+                << ",\"misses\":" << c.misses << ",\"evictions\":" << c.evictions << ",\"hit_rate\":" << c.hit_rate() << "}";
+        }
+        out << "}";
+        return out.str();
+    }
+
+    std::string answer(const std::string &line, SearchContext &ctx) {
+        auto cur = versions.current();  // held until the reply is formatted
+        const Graph &g = *cur;
+        std::istringstream in(line);
+        std::string src, tgt, algo, metric_name;
+        in >> src;
+        if (src == "info") return info();
+        if (!(in >> tgt)) return "{\"error\":\"expected: <source> <target> [algorithm] [metric]\"}";
+        if (!(in >> algo)) algo = default_algo;
+        auto it = algos.find(algo);
+        if (it == algos.end()) return "{\"error\":\"unknown algorithm " + json_escape(algo) + "\"}";
+        int m = (in >> metric_name) ? g.find_metric(metric_name) : metric;
+        if (m < 0) return "{\"error\":\"unknown metric " + json_escape(metric_name) + "\"}";
+        // the hierarchy is preprocessed for one metric (ALT variants just lose their bound)
+        if (algo == "ch" && m != metric)
+            return "{\"error\":\"ch is built for metric " + json_escape(g.metric_name(metric)) + "\"}";
+        if (algo == "ch" && g.version() != ch_version) it = algos.find(algo = "bidir_astar");
+        ctx.metric = m;
+        int s, t;
+        try {
+            s = resolve(g, src);
+            t = resolve(g, tgt);
+        } catch (const std::exception &) {
+            return "{\"error\":\"bad node " + json_escape(src + " " + tgt) + "\"}";
+        }
+        if (s < 0 || t < 0) return "{\"error\":\"unknown node " + json_escape(s < 0 ? src : tgt) + "\"}";
+        int algo_id = (int)std::distance(algos.begin(), it);
+        Stats st = cached_query(cache.get(), CacheKey{s, t, algo_id * g.num_metrics() + m, g.version()},
+                                [&]() { return it->second(g, s, t, ctx); });
+        std::ostringstream out;
+        out << "{\"source\":" << g.to_external(s) << ",\"target\":" << g.to_external(t)
+            << ",\"algorithm\":\"" << algo << "\",\"metric\":\"" << json_escape(g.metric_name(m))
+            << "\",\"stats\":" << stats_json(st, g, with_path) << "}";
+        return out.str();
+    }
+
+    static bool is_update(const std::string &line) { return line.compare(0, 7, "update ") == 0; }
+
+    // replies for a run of update lines, applied as one batch
+    void apply_updates(const std::vector<std::string> &lines, std::vector<std::string> &replies) {
+        auto cur = versions.current();
+        std::vector<EdgeUpdate> batch;
+        std::vector<bool> parsed(lines.size());
+        for (size_t i = 0; i < lines.size(); ++i) {
+            EdgeUpdate up;
+            parsed[i] = parse_update(lines[i].substr(7), *cur, up);
+            if (parsed[i]) batch.push_back(up);
+        }
+        GraphVersions::Published p = versions.apply(batch, metric);
+        std::ostringstream ok;
+        ok << "{\"updates\":" << batch.size() << ",\"applied\":" << p.result.applied << ",\"missing\":" << p.result.missing
+           << ",\"version\":" << p.graph->version() << ",\"apply_ms\":" << p.copy_ms + p.apply_ms << "}";
+        for (size_t i = 0; i < lines.size(); ++i)
+            replies[i] = parsed[i] ? ok.str() : "{\"error\":\"expected: update set|close|insert <u> <v> [w]\"}";
+    }
+
+    // serve one stream until EOF
+    void serve(int in_fd, int out_fd) {
+        LineReader reader(in_fd);
+        std::vector<std::string> batch, replies;
+        std::string line;
+        while (reader.next(line, true)) {
+            batch.clear();
+            do {
+                if (!line.empty()) batch.push_back(line);
+            } while (batch.size() < max_batch && reader.next(line, false));
+            if (batch.empty()) continue;
+            replies.assign(batch.size(), std::string());
+            // alternate runs of queries (in parallel) and runs of updates (one version each)
+            for (size_t a = 0; a < batch.size(); ) {
+                size_t b = a;
+                const bool updates = is_update(batch[a]);
+                while (b < batch.size() && is_update(batch[b]) == updates) ++b;
+                if (updates) {
+                    std::vector<std::string> lines(batch.begin() + a, batch.begin() + b), out(b - a);
+                    apply_updates(lines, out);
+                    std::move(out.begin(), out.end(), replies.begin() + a);
+                } else {
+                    std::lock_guard<std::mutex> lock(pool_mu);
+                    pool.for_each((int)(b - a), 1, [&](int i, int worker) {
+                        replies[a + i] = answer(batch[a + i], contexts[worker]);
+                    });
+                }
+                a = b;
+            }
+            std::string out;
+            for (const auto &r : replies) { out += r; out += '\n'; }
+            if (!write_all(out_fd, out)) return;
+        }
+    }
+};
+
+static int serve_socket(Server &server, const std::string &path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) { std::cerr << "socket() failed\n"; return 1; }
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) { std::cerr << "Socket path too long: " << path << "\n"; return 1; }
+    std::snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path.c_str());
+    unlink(path.c_str());
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 64) < 0) {
+        std::cerr << "Failed to listen on " << path << "\n";
+        return 1;
+    }
+    std::cerr << "Listening on " << path << "\n";
+    while (true) {
+        int conn = accept(fd, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        std::thread([&server, conn]() { server.serve(conn, conn); close(conn); }).detach();
+    }
+    close(fd);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    std::vector<std::string> pos;
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        if (a == "--no-path" || a == "--no-ch" || a == "--directed") continue;
+        if (a.rfind("--", 0) == 0) { ++i; continue; }
+        pos.push_back(a);
+    }
+    bool snapshot = !pos.empty() && Graph::is_snapshot(pos[0]);
+    if (pos.size() < (snapshot ? 1u : 2u)) {
+        std::cerr << "Usage: " << argv[0] << " <cities.csv> <routes.csv> | <graph.rpg> [--socket path] [--threads N]\n"
+                  << "       [--landmarks K] [--landmark-file path] [--queue binary|radix|dary] [--reorder hilbert|bfs]\n"
+                  << "       [--batch N] [--cache N] [--no-path] [--no-ch] [--directed] [--metric NAME]\n"
+                  << "Reads '<source> <target> [algorithm] [metric]' lines (ids or lat,lon) and writes one JSON result per line.\n";
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+
+    auto t0 = std::chrono::high_resolution_clock::now();
+    Graph g;
+    if (snapshot) {
+        if (!g.load_snapshot(pos[0])) return 2;
+    } else {
+        if (!g.load_nodes_csv(pos[0])) return 2;
+        if (!g.load_edges_csv(pos[1], !has_flag(argc, argv, "--directed"))) return 3;
+    }
+    NodeOrder order = NodeOrder::Input;
+    if (!parse_node_order(flag_value(argc, argv, "--reorder", "input"), order)) { std::cerr << "Unknown order\n"; return 1; }
+    g.reorder(order);
+
+    int threads = std::stoi(flag_value(argc, argv, "--threads", std::to_string(default_threads())));
+    Server server(std::move(g), threads);
+    // CH, landmarks and the spatial index are built on the first version
+    auto first = server.versions.current();
+    const Graph &g0 = *first;
+    server.snap.build(g0);
+    server.with_path = !has_flag(argc, argv, "--no-path");
+    server.max_batch = (size_t)std::max(1, std::stoi(flag_value(argc, argv, "--batch", "256")));
+    QueueKind queue = QueueKind::Binary;
+    if (!parse_queue_kind(flag_value(argc, argv, "--queue", "binary"), queue)) { std::cerr << "Unknown queue\n"; return 1; }
+    for (auto &c : server.contexts) c.queue = queue;
+    std::string metric_name = flag_value(argc, argv, "--metric", g0.metric_name(0));
+    server.metric = g0.find_metric(metric_name);
+    if (server.metric < 0) { std::cerr << "Unknown metric: " << metric_name << "\n"; return 1; }
+    size_t cache_size = std::stoul(flag_value(argc, argv, "--cache", "0"));
+    if (cache_size > 0) server.cache = std::make_unique<ResultCache>(cache_size);
+
+    server.algos["dijkstra"] = [](const Graph &g, int s, int t, SearchContext &ctx) { return dijkstra_search(g, s, t, ctx); };
+    server.algos["astar"] = [](const Graph &g, int s, int t, SearchContext &ctx) { return astar_search(g, s, t, ctx); };
+    server.algos["bidir_dijkstra"] = [](const Graph &g, int s, int t, SearchContext &ctx) { return bidir_dijkstra_search(g, s, t, ctx); };
+    server.algos["bidir_astar"] = [](const Graph &g, int s, int t, SearchContext &ctx) { return bidir_astar_search(g, s, t, ctx); };
+    server.default_algo = "dijkstra";
+
+    ContractionHierarchy ch;
+    server.ch_version = g0.version();
+    if (!has_flag(argc, argv, "--no-ch")) {
+        ch.build(g0, server.metric);
+        server.algos["ch"] = [&](const Graph &, int s, int t, SearchContext &ctx) { return ch_search(ch, s, t, ctx); };
+        server.default_algo = "ch";
+    }
+    Landmarks lm;
+    int num_landmarks = std::stoi(flag_value(argc, argv, "--landmarks", "0"));
+    std::string landmark_file = flag_value(argc, argv, "--landmark-file", "");
+    if (num_landmarks > 0 || !landmark_file.empty()) {
+        if (landmark_file.empty() || !lm.load(landmark_file, g0, server.metric)) {
+            lm.build(g0, num_landmarks > 0 ? num_landmarks : 16, LandmarkSelection::Avoid, 0, 1, server.metric);
+            if (!landmark_file.empty()) lm.save(landmark_file);
+        }
+        // landmark distances stay lower bounds while weights only go up
+        auto bounds = [&]() { return server.versions.lower_bounds_hold() ? &lm : nullptr; };
+        server.algos["astar_alt"] = [bounds](const Graph &g, int s, int t, SearchContext &ctx) { return astar_search(g, s, t, ctx, bounds()); };
+        server.algos["bidir_astar_alt"] = [bounds](const Graph &g, int s, int t, SearchContext &ctx) { return bidir_astar_search(g, s, t, ctx, bounds()); };
+    }
+    auto t1 = std::chrono::high_resolution_clock::now();
+    // status goes to stderr so stdout carries only responses
+    std::cerr << "Ready: nodes=" << g0.num_nodes() << " edges=" << g0.num_edges() << " workers=" << server.pool.size()
+              << " startup_ms=" << std::chrono::duration<double, std::milli>(t1 - t0).count() << "\n";
+
+    std::string socket_path = flag_value(argc, argv, "--socket", "");
+    if (!socket_path.empty()) return serve_socket(server, socket_path);
+    server.serve(0, 1);
+    return 0;
+}
@@ -0,0 +1,66 @@
+#ifndef SEARCH_CONTEXT_H
+#define SEARCH_CONTEXT_H
+
+#include "priority_queues.h"
+#include <cstdint>
+#include <vector>
+#include <limits>
+
+/* Search state reused across queries (one context per thread).
+   Arrays are sized to the graph once; each side remembers the nodes it
+   touched so prepare() only resets those, making a short query O(touched)
+   instead of O(n). Searches must go through Side::set() when a node's
+   distance first becomes finite so the node is recorded.
+*/
+class SearchContext {
+public:
+    struct Side {
+        std::vector<double> dist;   // INF when untouched
+        std::vector<int> parent;    // -1 when untouched
+        std::vector<int> aux;       // algorithm specific (CH: middle node of the parent edge), -1 when untouched
+        std::vector<char> closed;   // 0 when untouched
+        std::vector<int> touched;
+        // one queue per kind; the kernels use the one selected by SearchContext::queue
+        BinaryHeapQueue binary;
+        RadixHeapQueue radix;
+        FourAryHeapQueue dary;
+
+        void set(int v, double d, int p, int a = -1) {
+            if (dist[v] == std::numeric_limits<double>::infinity()) touched.push_back(v);
+            dist[v] = d;
+            parent[v] = p;
+            aux[v] = a;
+        }
+
+        void prepare(int n) {
+            for (int v : touched) {
+                dist[v] = std::numeric_limits<double>::infinity();
+                parent[v] = -1;
+                aux[v] = -1;
+                closed[v] = 0;
+            }
+            touched.clear();
+            binary.clear(); radix.clear(); dary.clear();
+            if ((int)dist.size() < n) {
+                dist.resize(n, std::numeric_limits<double>::infinity());
+                parent.resize(n, -1);
+                aux.resize(n, -1);
+                closed.resize(n, 0);
+            }
+        }
+    };
+
+    Side fwd, bwd;
+    QueueKind queue = QueueKind::Binary; // priority queue used by Dijkstra and the A* variants
+    int metric = 0;                      // edge metric the searches use (Graph::find_metric)
+    // multi-source searches: one distance per source lane, node-major
+    std::vector<double> lanes;
+
+    // clear whatever the previous query touched and make room for n nodes
+    void prepare(int n) {
+        fwd.prepare(n);
+        bwd.prepare(n);
+    }
+};
+
+#endif // SEARCH_CONTEXT_H
@@ -0,0 +1,275 @@
+// Binary graph snapshot: save/load for Graph.
+//
+// Layout (native endianness, every section starts 8-byte aligned):
+//   header        64 bytes, see SnapshotHeader
+//   coords        num_nodes * (lat, lon) doubles
+//   name offsets  (num_nodes+1) uint64, into the names blob
+//   names blob    names_bytes chars
+//   edge offsets  (num_nodes+1) int32 (CSR)
+//   targets       num_edges int32
+//   weights       num_edges weight_t (weight_bytes each)
+//   external ids  num_nodes int32, only with SNAPSHOT_FLAG_ID_MAP (reordered graphs)
+//   reversed CSR  (num_nodes+1) int32 offsets, num_edges int32 sources, num_edges
+//                 weight_t weights, only with SNAPSHOT_FLAG_DIRECTED
+//   metrics       only with SNAPSHOT_FLAG_METRICS: uint64 {K, names_bytes},
+//                 K doubles (scales), (K+2) uint64 name offsets (metric 0..K),
+//                 names blob, then per extra metric num_edges uint32 (and
+//                 num_edges uint32 in reversed order when directed)
+// The checksum covers everything after the header (padding included).
+// Version 1 is the plain layout (coords to weights). Files with any optional
+// section are version 2, so readers that predate the sections reject them as
+// an unsupported version; unknown flag bits, and flags on a version 1 file, are
+// rejected the same way.
+#include "graph.h"
+#include "mapped_file.h"
+#include <fstream>
+#include <iostream>
+#include <cstring>
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = {'R','P','G','R','A','P','H','\0'};
+const uint32_t SNAPSHOT_VERSION_PLAIN = 1;
+const uint32_t SNAPSHOT_VERSION = 2;
+const uint64_t SNAPSHOT_FLAG_ID_MAP = 1;
+const uint64_t SNAPSHOT_FLAG_DIRECTED = 2;
+const uint64_t SNAPSHOT_FLAG_METRICS = 4;
+const uint64_t SNAPSHOT_KNOWN_FLAGS = SNAPSHOT_FLAG_ID_MAP | SNAPSHOT_FLAG_DIRECTED | SNAPSHOT_FLAG_METRICS;
+
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t weight_bytes;
+    uint64_t num_nodes;
+    uint64_t num_edges;
+    uint64_t names_bytes;
+    uint64_t checksum;
+    uint64_t flags;
+    uint64_t reserved;
+};
+static_assert(sizeof(SnapshotHeader) == 64, "snapshot header must stay 64 bytes");
+
+inline uint64_t pad8(uint64_t x) { return (x + 7) & ~(uint64_t)7; }
+
+// FNV-1a over 64-bit words; a partial last word is zero padded, which
+// matches the zero padding written after every section
+struct Checksum {
+    uint64_t h = 1469598103934665603ULL;
+    void add(const char *p, size_t len) {
+        size_t i = 0;
+        for (; i + 8 <= len; i += 8) {
+            uint64_t w;
+            std::memcpy(&w, p + i, 8);
+            h = (h ^ w) * 1099511628211ULL;
+        }
+        if (i < len) {
+            uint64_t w = 0;
+            std::memcpy(&w, p + i, len - i);
+            h = (h ^ w) * 1099511628211ULL;
+        }
+    }
+};
+
+// writes one section plus zero padding and feeds it to the checksum
+void write_section(std::ofstream &out, Checksum &sum, const void *data, size_t len) {
+    static const char zeros[8] = {0};
+    const char *p = static_cast<const char*>(data);
+    if (len) out.write(p, len);
+    out.write(zeros, pad8(len) - len);
+    sum.add(p, len);
+}
+
+} // namespace
+
+bool Graph::is_snapshot(const std::string &path) {
+    std::ifstream in(path, std::ios::binary);
+    char magic[8];
+    if (!in.read(magic, 8)) return false;
+    return std::memcmp(magic, SNAPSHOT_MAGIC, 8) == 0;
+}
+
+bool Graph::save_snapshot(const std::string &path) const {
+    std::ofstream out(path, std::ios::binary);
+    if (!out.is_open()) { std::cerr << "Failed to open: " << path << "\n"; return false; }
+
+    std::vector<uint64_t> name_offsets(n_ + 1, 0);
+    std::string blob;
+    NameTable nt = get_names();
+    for (int i = 0; i < n_; ++i) {
+        blob.append(nt[i].data(), nt[i].size());
+        name_offsets[i+1] = blob.size();
+    }
+
+    SnapshotHeader h{};
+    std::memcpy(h.magic, SNAPSHOT_MAGIC, 8);
+    h.weight_bytes = sizeof(weight_t);
+    h.num_nodes = n_;
+    h.num_edges = m_;
+    h.names_bytes = blob.size();
+    const bool with_metrics = !extra_metrics.empty() || metric0_name != "distance";
+    h.flags = (is_reordered() ? SNAPSHOT_FLAG_ID_MAP : 0) | (directed_ ? SNAPSHOT_FLAG_DIRECTED : 0)
+            | (with_metrics ? SNAPSHOT_FLAG_METRICS : 0);
+    h.version = h.flags ? SNAPSHOT_VERSION : SNAPSHOT_VERSION_PLAIN;
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h)); // checksum patched below
+
+    Checksum sum;
+    write_section(out, sum, coords_v, sizeof(std::pair<double,double>) * n_);
+    write_section(out, sum, name_offsets.data(), sizeof(uint64_t) * name_offsets.size());
+    write_section(out, sum, blob.data(), blob.size());
+    write_section(out, sum, offsets_v, sizeof(int) * (n_ + 1));
+    write_section(out, sum, targets_v, sizeof(int) * m_);
+    write_section(out, sum, weights_v, sizeof(weight_t) * m_);
+    if (is_reordered()) write_section(out, sum, external_ids.data(), sizeof(int) * n_);
+    if (directed_) {
+        write_section(out, sum, rev_offsets_v, sizeof(int) * (n_ + 1));
+        write_section(out, sum, rev_sources_v, sizeof(int) * m_);
+        write_section(out, sum, rev_weights_v, sizeof(weight_t) * m_);
+    }
+    if (with_metrics) {
+        std::vector<double> scales;
+        std::vector<uint64_t> metric_name_offsets(1, 0);
+        std::string metric_blob;
+        for (int k = 0; k < num_metrics(); ++k) {
+            if (k > 0) scales.push_back(extra_metrics[k-1].scale);
+            metric_blob += metric_name(k);
+            metric_name_offsets.push_back(metric_blob.size());
+        }
+        uint64_t counts[2] = {extra_metrics.size(), metric_blob.size()};
+        write_section(out, sum, counts, sizeof(counts));
+        write_section(out, sum, scales.data(), sizeof(double) * scales.size());
+        write_section(out, sum, metric_name_offsets.data(), sizeof(uint64_t) * metric_name_offsets.size());
+        write_section(out, sum, metric_blob.data(), metric_blob.size());
+        for (const auto &mc : extra_metrics) {
+            write_section(out, sum, mc.q_v, sizeof(uint32_t) * m_);
+            if (directed_) write_section(out, sum, mc.rev_q_v, sizeof(uint32_t) * m_);
+        }
+    }
+
+    h.checksum = sum.h;
+    out.seekp(0);
+    out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    return (bool)out;
+}
+
+bool Graph::load_snapshot(const std::string &path, bool verify) {
+    auto file = std::make_shared<MappedFile>();
+    if (!file->open(path)) { std::cerr << "Failed to open: " << path << "\n"; return false; }
+    if (file->size() < sizeof(SnapshotHeader)) { std::cerr << "Snapshot too small: " << path << "\n"; return false; }
+    SnapshotHeader h;
+    std::memcpy(&h, file->data(), sizeof(h));
+    if (std::memcmp(h.magic, SNAPSHOT_MAGIC, 8) != 0) { std::cerr << "Not a graph snapshot: " << path << "\n"; return false; }
+    if (h.version != SNAPSHOT_VERSION && h.version != SNAPSHOT_VERSION_PLAIN) {
+        std::cerr << "Unsupported snapshot version " << h.version << " in " << path << "\n";
+        return false;
+    }
+    if (h.version == SNAPSHOT_VERSION_PLAIN && h.flags != 0) {
+        std::cerr << "Snapshot " << path << " is version " << h.version << " but has section flags " << h.flags
+                  << "; optional sections need version " << SNAPSHOT_VERSION << "\n";
+        return false;
+    }
+    if (h.flags & ~SNAPSHOT_KNOWN_FLAGS) {
+        std::cerr << "Snapshot " << path << " has unsupported sections (flags " << h.flags << "), written by a newer version\n";
+        return false;
+    }
+    if (h.weight_bytes != sizeof(weight_t)) {
+        std::cerr << "Snapshot " << path << " has " << h.weight_bytes << "-byte weights, this build uses "
+                  << sizeof(weight_t) << " (ROUTE_FLOAT_WEIGHTS mismatch)\n";
+        return false;
+    }
+
+    const uint64_t n = h.num_nodes, m = h.num_edges;
+    uint64_t off = sizeof(SnapshotHeader);
+    const uint64_t coords_off = off;  off += pad8(sizeof(std::pair<double,double>) * n);
+    const uint64_t noff_off = off;    off += pad8(sizeof(uint64_t) * (n + 1));
+    const uint64_t blob_off = off;    off += pad8(h.names_bytes);
+    const uint64_t eoff_off = off;    off += pad8(sizeof(int) * (n + 1));
+    const uint64_t tgt_off = off;     off += pad8(sizeof(int) * m);
+    const uint64_t w_off = off;       off += pad8(sizeof(weight_t) * m);
+    const bool id_map = h.flags & SNAPSHOT_FLAG_ID_MAP;
+    const uint64_t ids_off = off;     if (id_map) off += pad8(sizeof(int) * n);
+    const bool directed = h.flags & SNAPSHOT_FLAG_DIRECTED;
+    const uint64_t roff_off = off;    if (directed) off += pad8(sizeof(int) * (n + 1));
+    const uint64_t rsrc_off = off;    if (directed) off += pad8(sizeof(int) * m);
+    const uint64_t rw_off = off;      if (directed) off += pad8(sizeof(weight_t) * m);
+    const char *base = file->data();
+    // metric table: sized by its own counts, which must be read first
+    uint64_t counts[2] = {0, 0};
+    const bool with_metrics = h.flags & SNAPSHOT_FLAG_METRICS;
+    if (with_metrics) {
+        if (off + sizeof(counts) > file->size()) { std::cerr << "Truncated or corrupt snapshot: " << path << "\n"; return false; }
+        std::memcpy(counts, base + off, sizeof(counts));
+        if (counts[0] > (1u << 16) || counts[1] > file->size()) { std::cerr << "Corrupt metric table in snapshot: " << path << "\n"; return false; }
+    }
+    const uint64_t k = counts[0];
+    off += with_metrics ? pad8(sizeof(counts)) : 0;
+    const uint64_t scales_off = off;  off += pad8(sizeof(double) * k);
+    const uint64_t mnoff_off = off;   if (with_metrics) off += pad8(sizeof(uint64_t) * (k + 2));
+    const uint64_t mblob_off = off;   off += pad8(counts[1]);
+    const uint64_t q_off = off;       off += k * (directed ? 2 : 1) * pad8(sizeof(uint32_t) * m);
+    if (off != file->size()) { std::cerr << "Truncated or corrupt snapshot: " << path << "\n"; return false; }
+
+    if (verify) {
+        Checksum sum;
+        sum.add(base + sizeof(SnapshotHeader), file->size() - sizeof(SnapshotHeader));
+        if (sum.h != h.checksum) { std::cerr << "Snapshot checksum mismatch: " << path << "\n"; return false; }
+    }
+    const int *eoff = reinterpret_cast<const int*>(base + eoff_off);
+    if (eoff[0] != 0 || (uint64_t)eoff[n] != m) { std::cerr << "Corrupt edge offsets in snapshot: " << path << "\n"; return false; }
+    const int *roff = reinterpret_cast<const int*>(base + roff_off);
+    if (directed && (roff[0] != 0 || (uint64_t)roff[n] != m)) { std::cerr << "Corrupt reversed edge offsets in snapshot: " << path << "\n"; return false; }
+
+    external_ids.clear(); internal_ids.clear();
+    if (id_map) {
+        const int *ext = reinterpret_cast<const int*>(base + ids_off);
+        external_ids.assign(ext, ext + n);
+        internal_ids.assign(n, -1);
+        for (uint64_t i = 0; i < n; ++i) {
+            if (ext[i] < 0 || (uint64_t)ext[i] >= n || internal_ids[ext[i]] != -1) {
+                std::cerr << "Corrupt id map in snapshot: " << path << "\n";
+                external_ids.clear(); internal_ids.clear();
+                return false;
+            }
+            internal_ids[ext[i]] = (int)i;
+        }
+    }
+    std::string weight_name = "distance";
+    std::vector<MetricColumn> metrics(k);
+    if (with_metrics) {
+        const uint64_t *noff = reinterpret_cast<const uint64_t*>(base + mnoff_off);
+        const double *scales = reinterpret_cast<const double*>(base + scales_off);
+        for (uint64_t i = 0; i <= k; ++i) {
+            if (noff[i] > noff[i+1] || noff[i+1] > counts[1]) { std::cerr << "Corrupt metric table in snapshot: " << path << "\n"; return false; }
+            std::string name(base + mblob_off + noff[i], noff[i+1] - noff[i]);
+            if (i == 0) { weight_name = name; continue; }
+            metrics[i-1].name = name;
+            metrics[i-1].scale = scales[i-1];
+            uint64_t arrays = q_off + (i-1) * (directed ? 2 : 1) * pad8(sizeof(uint32_t) * m);
+            metrics[i-1].q_v = reinterpret_cast<const uint32_t*>(base + arrays);
+            if (directed) metrics[i-1].rev_q_v = reinterpret_cast<const uint32_t*>(base + arrays + pad8(sizeof(uint32_t) * m));
+        }
+    }
+    coords.clear(); names.clear(); offsets.assign(1, 0); targets.clear(); weights.clear();
+    coords.shrink_to_fit(); names.shrink_to_fit(); targets.shrink_to_fit(); weights.shrink_to_fit();
+    rev_offsets.clear(); rev_sources.clear(); rev_weights.clear();
+    rev_offsets.shrink_to_fit(); rev_sources.shrink_to_fit(); rev_weights.shrink_to_fit();
+    directed_ = directed;
+    metric0_name = weight_name;
+    extra_metrics.swap(metrics);
+    n_ = (int)n;
+    m_ = (size_t)m;
+    coords_v = reinterpret_cast<const std::pair<double,double>*>(base + coords_off);
+    names_v = nullptr;
+    name_offsets_v = reinterpret_cast<const uint64_t*>(base + noff_off);
+    names_blob_v = base + blob_off;
+    offsets_v = eoff;
+    targets_v = reinterpret_cast<const int*>(base + tgt_off);
+    weights_v = reinterpret_cast<const weight_t*>(base + w_off);
+    rev_offsets_v = directed ? roff : nullptr;
+    rev_sources_v = directed ? reinterpret_cast<const int*>(base + rsrc_off) : nullptr;
+    rev_weights_v = directed ? reinterpret_cast<const weight_t*>(base + rw_off) : nullptr;
+    mapping = file;
+    shared_base.reset();
+    own_weights_ = false;
+    bump_version();
+    return true;
+}
@@ -0,0 +1,112 @@
+#include "spatial_index.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <queue>
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+static const double EARTH_RADIUS_KM = 6371.0;
+
+SpatialIndex::Point SpatialIndex::to_point(double lat, double lon) {
+    const double r = M_PI / 180.0;
+    double cl = std::cos(lat * r);
+    return {cl * std::cos(lon * r), cl * std::sin(lon * r), std::sin(lat * r)};
+}
+
+void SpatialIndex::build(const Graph &g) {
+    const int n = g.num_nodes();
+    const auto coords = g.get_coords();
+    struct Item { Point p; int id; };
+    std::vector<Item> items(n);
+    for (int i = 0; i < n; ++i) items[i] = {to_point(coords[i].first, coords[i].second), i};
+    axis.assign(n, 0);
+
+    // split every range at its median along the axis of largest spread
+    std::vector<std::pair<int,int>> stack;
+    if (n > 1) stack.push_back({0, n});
+    while (!stack.empty()) {
+        auto [lo, hi] = stack.back();
+        stack.pop_back();
+        double mn[3] = {1e9, 1e9, 1e9}, mx[3] = {-1e9, -1e9, -1e9};
+        for (int i = lo; i < hi; ++i) {
+            for (int a = 0; a < 3; ++a) {
+                double c = coord(items[i].p, a);
+                mn[a] = std::min(mn[a], c);
+                mx[a] = std::max(mx[a], c);
+            }
+        }
+        int a = 0;
+        for (int b = 1; b < 3; ++b) if (mx[b] - mn[b] > mx[a] - mn[a]) a = b;
+        int mid = (lo + hi) / 2;
+        std::nth_element(items.begin() + lo, items.begin() + mid, items.begin() + hi,
+                         [a](const Item &x, const Item &y) { return coord(x.p, a) < coord(y.p, a); });
+        axis[mid] = (uint8_t)a;
+        if (mid - lo > 1) stack.push_back({lo, mid});
+        if (hi - (mid + 1) > 1) stack.push_back({mid + 1, hi});
+    }
+
+    ids.resize(n);
+    pts.resize(n);
+    slot.assign(n, -1);
+    for (int i = 0; i < n; ++i) {
+        ids[i] = items[i].id;
+        pts[i] = items[i].p;
+        slot[items[i].id] = i;
+    }
+}
+
+template <typename Visit>
+void SpatialIndex::search(int lo, int hi, const Point &q, double &bound, Visit &visit) const {
+    while (hi > lo) {
+        int mid = (lo + hi) / 2;
+        const Point &p = pts[mid];
+        double dx = p.x - q.x, dy = p.y - q.y, dz = p.z - q.z;
+        double d2 = dx*dx + dy*dy + dz*dz;
+        if (d2 < bound) visit(mid, d2);
+        if (hi - lo == 1) return;
+        double diff = coord(q, axis[mid]) - coord(p, axis[mid]);
+        // near side first; the far side only if the splitting plane is closer than the bound
+        int nlo = diff < 0 ? lo : mid + 1, nhi = diff < 0 ? mid : hi;
+        int flo = diff < 0 ? mid + 1 : lo, fhi = diff < 0 ? hi : mid;
+        search(nlo, nhi, q, bound, visit);
+        if (diff * diff >= bound) return;
+        lo = flo; hi = fhi;
+    }
+}
+
+int SpatialIndex::nearest(double lat, double lon) const {
+    if (ids.empty()) return -1;
+    Point q = to_point(lat, lon);
+    double bound = std::numeric_limits<double>::infinity();
+    int best = -1;
+    auto visit = [&](int i, double d2) { bound = d2; best = i; };
+    search(0, (int)ids.size(), q, bound, visit);
+    return ids[best];
+}
+
+std::vector<int> SpatialIndex::k_nearest(double lat, double lon, int k) const {
+    std::vector<int> out;
+    if (k <= 0 || ids.empty()) return out;
+    Point q = to_point(lat, lon);
+    double bound = std::numeric_limits<double>::infinity();
+    std::priority_queue<std::pair<double,int>> heap; // farthest of the current k on top
+    auto visit = [&](int i, double d2) {
+        heap.push({d2, i});
+        if ((int)heap.size() > k) heap.pop();
+        if ((int)heap.size() == k) bound = heap.top().first;
+    };
+    search(0, (int)ids.size(), q, bound, visit);
+    out.resize(heap.size());
+    for (int i = (int)heap.size() - 1; i >= 0; --i) { out[i] = ids[heap.top().second]; heap.pop(); }
+    return out;
+}
+
+double SpatialIndex::distance_km(double lat, double lon, int node) const {
+    Point q = to_point(lat, lon);
+    const Point &p = pts[slot[node]];
+    double dx = p.x - q.x, dy = p.y - q.y, dz = p.z - q.z;
+    double chord = std::sqrt(dx*dx + dy*dy + dz*dz);
+    return 2.0 * EARTH_RADIUS_KM * std::asin(std::min(1.0, chord / 2.0));
+}
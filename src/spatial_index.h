@@ -0,0 +1,46 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "graph.h"
+#include <vector>
+#include <cstdint>
+
+/* Static k-d tree over the node coordinates, for snapping GPS positions
+   to graph nodes.
+   Points are stored as unit vectors on the sphere, so straight-line (chord)
+   distance orders nodes exactly like great-circle distance and there is no
+   special case at the antimeridian or the poles. The tree is implicit: the
+   node ids are permuted so every subtree is a contiguous range whose median
+   is the split point.
+*/
+class SpatialIndex {
+public:
+    SpatialIndex() = default;
+    explicit SpatialIndex(const Graph &g) { build(g); }
+    void build(const Graph &g);
+
+    int size() const { return (int)ids.size(); }
+    bool empty() const { return ids.empty(); }
+
+    // closest node to (lat, lon) in degrees, -1 when the index is empty
+    int nearest(double lat, double lon) const;
+    // up to k closest nodes, nearest first
+    std::vector<int> k_nearest(double lat, double lon, int k) const;
+    // great-circle distance in km from (lat, lon) to an indexed node
+    double distance_km(double lat, double lon, int node) const;
+
+private:
+    struct Point { double x, y, z; };
+    std::vector<int> ids;        // node ids in tree order
+    std::vector<Point> pts;      // pts[i] belongs to ids[i]
+    std::vector<uint8_t> axis;   // split axis of the subtree whose median is i
+    std::vector<int> slot;       // node id -> position in tree order
+
+    static Point to_point(double lat, double lon);
+    static double coord(const Point &p, int a) { return a == 0 ? p.x : (a == 1 ? p.y : p.z); }
+    // visit(i, d2) for candidates in [lo, hi) that may beat bound (squared chord); visit may shrink bound
+    template <typename Visit>
+    void search(int lo, int hi, const Point &q, double &bound, Visit &visit) const;
+};
+
+#endif // SPATIAL_INDEX_H
@@ -0,0 +1,215 @@
+#include "synthetic.h"
+#include "planner.h"
+#include "spatial_index.h"
+#include "parallel.h"
+#include <cmath>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+const char* synthetic_kind_name(SyntheticKind k) {
+    switch (k) {
+        case SyntheticKind::Geometric: return "geometric";
+        case SyntheticKind::Road: return "road";
+        default: return "grid";
+    }
+}
+
+bool parse_synthetic_kind(const std::string &s, SyntheticKind &out) {
+    if (s == "grid") { out = SyntheticKind::Grid; return true; }
+    if (s == "geometric" || s == "rgg") { out = SyntheticKind::Geometric; return true; }
+    if (s == "road") { out = SyntheticKind::Road; return true; }
+    return false;
+}
+
+namespace {
+
+const double KM_PER_DEG_LAT = 111.195;
+
+// places nodes by km offsets from the centre and weighs edges by great-circle length
+struct Builder {
+    const SyntheticOptions &opt;
+    Graph g;
+    std::vector<RawEdge> edges;
+    double km_per_deg_lon;
+
+    explicit Builder(const SyntheticOptions &o)
+        : opt(o), km_per_deg_lon(KM_PER_DEG_LAT * std::cos(o.center_lat * M_PI / 180.0)) {}
+
+    void node(int id, double x_km, double y_km) {
+        g.set_node(id, opt.center_lat + y_km / KM_PER_DEG_LAT, opt.center_lon + x_km / km_per_deg_lon,
+                   "S" + std::to_string(id));
+    }
+    // factor >= 1 models detours and speed; 1 is a straight road at the reference speed
+    void edge(int u, int v, double factor) {
+        auto c = g.get_coords();
+        double d = haversine_km(c[u].first, c[u].second, c[v].first, c[v].second);
+        edges.push_back({u, v, d * factor});
+    }
+    Graph finish() {
+        g.add_edges(edges, true);
+        return std::move(g);
+    }
+};
+
+// side x side lattice centred on the origin; each node displaced by up to jitter * spacing per axis
+int place_lattice(Builder &b, std::mt19937 &rng, double jitter) {
+    const SyntheticOptions &opt = b.opt;
+    const int side = std::max(2, (int)std::ceil(std::sqrt((double)opt.nodes)));
+    const double half = side * opt.spacing_km / 2, j = jitter * opt.spacing_km;
+    std::uniform_real_distribution<double> shift(-j, j);
+    b.g.set_node(side * side - 1, 0.0, 0.0); // size the arrays once
+    for (int r = 0; r < side; ++r) {
+        for (int c = 0; c < side; ++c) {
+            double x = c * opt.spacing_km - half, y = r * opt.spacing_km - half;
+            if (j > 0) { x += shift(rng); y += shift(rng); }
+            b.node(r * side + c, x, y);
+        }
+    }
+    return side;
+}
+
+Graph grid_graph(const SyntheticOptions &opt, std::mt19937 &rng) {
+    Builder b(opt);
+    const int side = place_lattice(b, rng, opt.jitter < 0 ? 0.0 : opt.jitter);
+    // small random detour factors break the lattice's many equal-length ties
+    std::uniform_real_distribution<double> factor(1.0, 1.2);
+    b.edges.reserve(2 * (size_t)side * side);
+    for (int r = 0; r < side; ++r) {
+        for (int c = 0; c < side; ++c) {
+            int u = r * side + c;
+            if (c + 1 < side) b.edge(u, u + 1, factor(rng));
+            if (r + 1 < side) b.edge(u, u + side, factor(rng));
+        }
+    }
+    return b.finish();
+}
+
+Graph geometric_graph(const SyntheticOptions &opt, std::mt19937 &rng) {
+    const int n = std::max(2, opt.nodes);
+    const double box = opt.spacing_km * std::sqrt((double)n);
+    Builder b(opt);
+    std::uniform_real_distribution<double> pos(-box / 2, box / 2);
+    b.g.set_node(n - 1, 0.0, 0.0); // size the arrays once
+    for (int i = 0; i < n; ++i) b.node(i, pos(rng), pos(rng));
+    SpatialIndex index(b.g);
+    auto coords = b.g.get_coords();
+    std::uniform_real_distribution<double> factor(1.0, 1.3);
+    // one flat row of k+1 neighbours per node (the node itself included)
+    const int k = opt.k_nearest + 1;
+    std::vector<int> near((size_t)n * k, -1);
+    parallel_for(n, default_threads(), [&](int u) {
+        auto nn = index.k_nearest(coords[u].first, coords[u].second, k);
+        auto first = near.begin() + (size_t)u * k;
+        std::copy(nn.begin(), nn.end(), first);
+        std::sort(first, first + k);
+    });
+    auto row = [&](int u) { return std::make_pair(near.begin() + (size_t)u * k, near.begin() + (size_t)(u + 1) * k); };
+    // undirected kNN graph: one edge per pair even when both ends picked each other
+    b.edges.reserve((size_t)n * opt.k_nearest);
+    for (int u = 0; u < n; ++u) {
+        auto ru = row(u);
+        for (auto it = ru.first; it != ru.second; ++it) {
+            int v = *it;
+            if (v == u || v < 0) continue;
+            auto rv = row(v);
+            if (v < u && std::binary_search(rv.first, rv.second, u)) continue;
+            b.edge(u, v, factor(rng));
+        }
+    }
+    return b.finish();
+}
+
+Graph road_graph(const SyntheticOptions &opt, std::mt19937 &rng) {
+    Builder b(opt);
+    const int side = place_lattice(b, rng, opt.jitter < 0 ? 0.3 : opt.jitter);
+    const int art = std::max(2, opt.arterial), motorway = art * art;
+    // higher levels are straighter (lower detour factor) and skip more nodes per link
+    std::uniform_real_distribution<double> local(1.2, 1.6), arterial(1.05, 1.15), coin(0.0, 1.0);
+    b.edges.reserve(2 * (size_t)side * side);
+    for (int r = 0; r < side; ++r) {
+        for (int c = 0; c < side; ++c) {
+            int u = r * side + c;
+            // rows and the first column are kept whole so the network stays connected
+            if (c + 1 < side) b.edge(u, u + 1, local(rng));
+            if (r + 1 < side && (c == 0 || coin(rng) > 0.25)) b.edge(u, u + side, local(rng));
+            if (r % art == 0 && c % art == 0) {
+                if (c + art < side) b.edge(u, u + art, arterial(rng));
+                if (r + art < side) b.edge(u, u + art * side, arterial(rng));
+            }
+            if (r % motorway == 0 && c % motorway == 0) {
+                if (c + motorway < side) b.edge(u, u + motorway, 1.0);
+                if (r + motorway < side) b.edge(u, u + motorway * side, 1.0);
+            }
+        }
+    }
+    return b.finish();
+}
+
+} // namespace
+
+Graph make_synthetic_graph(const SyntheticOptions &opt) {
+    std::mt19937 rng(opt.seed);
+    switch (opt.kind) {
+        case SyntheticKind::Geometric: return geometric_graph(opt, rng);
+        case SyntheticKind::Road: return road_graph(opt, rng);
+        default: return grid_graph(opt, rng);
+    }
+}
+
+std::vector<ProfileRow> make_synthetic_profiles(const Graph &g, unsigned seed, double speed_kmh) {
+    // (hour, share of the edge's congestion level) over one day
+    static const double shape[][2] = {{0, 0}, {6, 0}, {8, 1}, {10, 0.3}, {16, 0.3}, {17.5, 0.8}, {20, 0}};
+    // steepest fall of the shape per second; travel time may fall at most one second per
+    // second (FIFO), which caps the congestion level of edges with a long free-flow time
+    double fall = 0.0;
+    for (size_t i = 0; i + 1 < sizeof(shape) / sizeof(shape[0]); ++i)
+        fall = std::max(fall, (shape[i][1] - shape[i+1][1]) / ((shape[i+1][0] - shape[i][0]) * 3600.0));
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> level(0.0, 1.5);
+    std::vector<ProfileRow> rows;
+    std::vector<int> seen(g.num_nodes(), -1);  // parallel edges share the profile of their pair
+    for (int u = 0; u < g.num_nodes(); ++u) {
+        for (const auto &e : g.neighbors(u)) {
+            if ((!g.is_directed() && e.to < u) || seen[e.to] == u) continue;
+            seen[e.to] = u;
+            const double free_flow = e.w / speed_kmh * 3600.0;
+            const double c = std::min(level(rng), 0.99 / std::max(1e-12, free_flow * fall));
+            for (const auto &p : shape) rows.push_back({u, e.to, p[0] * 3600.0, free_flow * (1.0 + c * p[1])});
+        }
+    }
+    return rows;
+}
+
+std::vector<EdgeUpdate> make_synthetic_updates(const Graph &g, size_t count, unsigned seed, double insert_share) {
+    std::vector<EdgeUpdate> out;
+    const int n = g.num_nodes();
+    if (n == 0 || g.num_edges() == 0) return out;
+    const auto offsets = g.edge_offsets();
+    const auto targets = g.edge_targets();
+    const auto weights = g.edge_weights();
+    const auto coords = g.get_coords();
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<int> node(0, n-1);
+    std::uniform_real_distribution<double> unit(0.0, 1.0), factor(0.8, 2.0);
+    while (out.size() < count) {
+        int u = node(rng);
+        if (g.degree(u) == 0) continue;
+        int i = offsets[u] + (int)(unit(rng) * g.degree(u)) % g.degree(u);
+        int v = targets[i];
+        double r = unit(rng);
+        if (r < insert_share) {
+            if (g.degree(v) == 0) continue;
+            int w = targets[offsets[v] + (int)(unit(rng) * g.degree(v)) % g.degree(v)];
+            if (w == u) continue;
+            double km = haversine_km(coords[u].first, coords[u].second, coords[w].first, coords[w].second);
+            out.push_back({EdgeUpdate::Insert, u, w, km * (1.0 + unit(rng))});
+        } else if (r < insert_share + 0.1) {
+            out.push_back({EdgeUpdate::Close, u, v});
+        } else {
+            double w = std::isfinite((double)weights[i]) ? (double)weights[i] : 1.0;
+            out.push_back({EdgeUpdate::Set, u, v, w * factor(rng)});
+        }
+    }
+    return out;
+}
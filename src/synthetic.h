@@ -0,0 +1,55 @@
+#ifndef SYNTHETIC_H
+#define SYNTHETIC_H
+
+#include "graph.h"
+#include "time_profiles.h"
+#include <string>
+
+/* Synthetic graphs for benchmarks and scaling tests (route_bench,
+   graph_gen, batch_runner --synthetic).
+   Nodes get real lat/lon coordinates around a centre point and edge
+   weights are km, never below the great-circle distance of their
+   endpoints, so the A* heuristics stay admissible.
+     Grid       rows x cols lattice, 4-neighbour, optionally perturbed
+     Geometric  uniform random points, each linked to its k nearest
+     Road       hierarchical: jittered street grid with missing streets,
+                arterials every `arterial` rows/columns and motorways every
+                arterial*arterial, each level longer, straighter links
+   Generation is O(n) (O(n log n) for Geometric) and the output is a
+   regular owned Graph, so millions of nodes take seconds.
+*/
+enum class SyntheticKind { Grid, Geometric, Road };
+const char* synthetic_kind_name(SyntheticKind k);
+bool parse_synthetic_kind(const std::string &s, SyntheticKind &out);
+
+struct SyntheticOptions {
+    SyntheticKind kind = SyntheticKind::Grid;
+    int nodes = 10000;           // approximate; grids round to a full square
+    unsigned seed = 1;
+    double center_lat = 48.0, center_lon = 11.0;
+    double spacing_km = 0.25;    // typical distance between neighbouring nodes
+    int k_nearest = 6;           // Geometric only
+    double jitter = -1;          // node displacement as a fraction of spacing; < 0: kind default (Grid 0, Road 0.3)
+    int arterial = 8;            // Road only: arterial spacing in grid cells, motorways every arterial^2
+};
+
+Graph make_synthetic_graph(const SyntheticOptions &opt);
+
+/* Rush-hour travel-time profiles for TravelTimeProfiles::build (internal
+   ids, seconds of the day): every edge gets its free-flow time
+   w / speed_kmh, slowed by a random per-edge congestion level around a
+   morning and an evening peak. Undirected graphs get one set of rows per
+   pair. The level is capped per edge so that the travel time never falls
+   faster than the clock after a peak, which keeps the profiles FIFO even
+   on long links.
+*/
+std::vector<ProfileRow> make_synthetic_profiles(const Graph &g, unsigned seed = 1, double speed_kmh = 50.0);
+
+/* Traffic-like update stream for Graph::apply_updates (internal ids): mostly
+   weight changes of random edges (x0.8 .. x2 of their current metric-0
+   weight), about one closure in ten and a share of insertions between
+   nodes two hops apart, weighted no lower than their great-circle length.
+*/
+std::vector<EdgeUpdate> make_synthetic_updates(const Graph &g, size_t count, unsigned seed = 1, double insert_share = 0.01);
+
+#endif // SYNTHETIC_H
@@ -0,0 +1,171 @@
+#include "time_profiles.h"
+#include "mapped_file.h"
+#include "planner.h"
+#include <iostream>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+std::string_view next_line(const char *&p, const char *e) {
+    const char *nl = static_cast<const char*>(std::memchr(p, '\n', e - p));
+    const char *stop = nl ? nl : e;
+    std::string_view line(p, stop - p);
+    p = nl ? nl + 1 : e;
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    return line;
+}
+
+// next comma-separated field of line as a number; false at the end of the line or on garbage
+template <typename T>
+bool next_field(std::string_view line, size_t &pos, T &out) {
+    if (pos > line.size()) return false;
+    size_t comma = line.find(',', pos);
+    size_t stop = comma == std::string_view::npos ? line.size() : comma;
+    const char *p = line.data() + pos, *e = line.data() + stop;
+    while (p < e && (*p == ' ' || *p == '\t')) ++p;
+    auto r = std::from_chars(p, e, out);
+    if (r.ec != std::errc()) return false;
+    pos = stop + 1;
+    return true;
+}
+
+} // namespace
+
+bool TravelTimeProfiles::build(const Graph &g, std::vector<ProfileRow> rows, int metric, double period) {
+    const int n = g.num_nodes();
+    if (metric < 0 || metric >= g.num_metrics()) { std::cerr << "Profiles: unknown metric " << metric << "\n"; return false; }
+    if (!(period > 0)) { std::cerr << "Profiles: period must be positive\n"; return false; }
+    const size_t count = rows.size();
+    rows.reserve(g.is_directed() ? count : 2 * count);
+    for (size_t k = 0; k < count; ++k) {
+        ProfileRow &r = rows[k];
+        if (r.u < 0 || r.u >= n || r.v < 0 || r.v >= n) {
+            std::cerr << "Profiles: node out of range in row " << r.u << "," << r.v << "\n";
+            return false;
+        }
+        r.time -= period * std::floor(r.time / period);
+        if (!g.is_directed() && r.u != r.v) rows.push_back({r.v, r.u, r.time, r.travel});
+    }
+    std::sort(rows.begin(), rows.end(), [](const ProfileRow &a, const ProfileRow &b) {
+        return a.u != b.u ? a.u < b.u : a.v != b.v ? a.v < b.v : a.time < b.time;
+    });
+
+    // one group of breakpoints per (u, v); edge_group maps CSR positions to their group
+    const auto offsets = g.edge_offsets();
+    const auto targets = g.edge_targets();
+    std::vector<Point> group_points;
+    std::vector<uint32_t> group_first{0};
+    std::vector<int> edge_group(g.num_edges(), -1);
+    for (size_t a = 0; a < rows.size(); ) {
+        size_t b = a;
+        while (b < rows.size() && rows[b].u == rows[a].u && rows[b].v == rows[a].v) ++b;
+        const int u = rows[a].u, v = rows[a].v;
+        const size_t base = group_points.size();
+        for (size_t k = a; k < b; ++k) group_points.push_back({(float)rows[k].time, (float)rows[k].travel});
+        // checked on the stored floats, which is what the searches evaluate
+        const size_t len = b - a;
+        for (size_t k = 0; k < len; ++k) {
+            const Point &p = group_points[base + k], &q = group_points[base + (k + 1) % len];
+            double dt = k + 1 < len ? (double)q.time - p.time : (double)q.time + period - p.time;
+            if (p.travel < 0) {
+                std::cerr << "Profiles: negative travel time on edge " << g.to_external(u) << "," << g.to_external(v) << "\n";
+                return false;
+            }
+            if (len > 1 && k + 1 < len && dt <= 0) {
+                std::cerr << "Profiles: duplicate time " << p.time << " on edge " << g.to_external(u) << "," << g.to_external(v) << "\n";
+                return false;
+            }
+            if (len > 1 && (double)q.travel - p.travel < -dt) {
+                std::cerr << "Profiles: edge " << g.to_external(u) << "," << g.to_external(v)
+                          << " violates FIFO after time " << p.time << "\n";
+                return false;
+            }
+        }
+        bool found = false;
+        for (int i = offsets[u]; i < offsets[u+1]; ++i) {
+            if (targets[i] != v) continue;
+            edge_group[i] = (int)group_first.size() - 1;
+            found = true;
+        }
+        if (!found) {
+            std::cerr << "Profiles: no edge " << g.to_external(u) << "," << g.to_external(v) << "\n";
+            return false;
+        }
+        group_first.push_back((uint32_t)group_points.size());
+        a = b;
+    }
+
+    // lay the groups out per edge position (parallel edges get their own copy)
+    std::vector<uint32_t> new_first;
+    std::vector<Point> new_points;
+    size_t new_profiled = 0;
+    if (!rows.empty()) {
+        new_first.assign(g.num_edges() + 1, 0);
+        for (size_t i = 0; i < g.num_edges(); ++i) {
+            new_first[i] = (uint32_t)new_points.size();
+            if (edge_group[i] < 0) continue;
+            new_points.insert(new_points.end(), group_points.begin() + group_first[edge_group[i]],
+                              group_points.begin() + group_first[edge_group[i] + 1]);
+            new_profiled++;
+        }
+        new_first[g.num_edges()] = (uint32_t)new_points.size();
+    }
+
+    // admissible A* scale: smallest lower bound on an edge's travel time per km
+    const auto &coords = g.get_coords();
+    double scale = std::numeric_limits<double>::infinity();
+    for (int u = 0; u < n; ++u) {
+        size_t i = offsets[u];
+        for (const auto &e : g.neighbors(u, metric)) {
+            double lb = e.w;
+            if (!new_first.empty() && new_first[i] != new_first[i+1]) {
+                lb = std::numeric_limits<double>::infinity();
+                for (uint32_t k = new_first[i]; k < new_first[i+1]; ++k) lb = std::min(lb, (double)new_points[k].travel);
+            }
+            double km = haversine_km(coords[u].first, coords[u].second, coords[e.to].first, coords[e.to].second);
+            if (km > 0) scale = std::min(scale, lb / km);
+            ++i;
+        }
+    }
+
+    metric_ = metric;
+    period_ = period;
+    version_ = g.version();
+    profiled = new_profiled;
+    geo_scale_ = std::isfinite(scale) ? scale : 0.0;
+    first = std::move(new_first);
+    points = std::move(new_points);
+    return true;
+}
+
+bool TravelTimeProfiles::load_csv(const std::string &path, const Graph &g, int metric, double period) {
+    MappedFile file;
+    if (!file.open(path)) { std::cerr << "Failed to open: " << path << "\n"; return false; }
+    std::vector<ProfileRow> rows;
+    const char *p = file.data(), *e = p + file.size();
+    int line_num = 0;
+    bool header_checked = false;
+    for (; p < e; ) {
+        std::string_view line = next_line(p, e);
+        ++line_num;
+        if (line.empty()) continue;
+        size_t pos = 0;
+        int u, v;
+        double time, travel;
+        bool ok = next_field(line, pos, u) && next_field(line, pos, v) && next_field(line, pos, time) && next_field(line, pos, travel);
+        if (!header_checked) {
+            header_checked = true;
+            if (!ok) continue;
+        }
+        if (!ok || u < 0 || v < 0 || u >= g.num_nodes() || v >= g.num_nodes()) {
+            std::cerr << "Parse error at line " << line_num << ": " << line << "\n";
+            continue;
+        }
+        rows.push_back({g.to_internal(u), g.to_internal(v), time, travel});
+    }
+    return build(g, std::move(rows), metric, period);
+}
@@ -0,0 +1,86 @@
+#ifndef TIME_PROFILES_H
+#define TIME_PROFILES_H
+
+#include "graph.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+// one breakpoint of a travel-time profile as given to TravelTimeProfiles::build:
+// entering edge u->v (internal ids) at `time` takes `travel`
+struct ProfileRow {
+    int u, v;
+    double time, travel;
+};
+
+/* Piecewise-linear, periodic travel-time profiles for time-dependent routing.
+   A profile is a list of (time of day, travel time) breakpoints; between
+   breakpoints the travel time is interpolated linearly, and the last
+   breakpoint interpolates towards the first one of the next period.
+   Edges without a profile take the static weight of metric(), so a few
+   congested roads can be profiled on top of an ordinary graph.
+
+   Memory: all breakpoints live in one pooled array, edge i owning
+   points[first[i] .. first[i+1]) (CSR over edge positions), so the
+   overhead is 4 bytes per edge plus 8 bytes per breakpoint (float time
+   and travel time) instead of a vector per edge.
+
+   Profiles must satisfy FIFO (leaving later never arrives earlier, i.e.
+   every slope >= -1); build() rejects them otherwise, since the
+   label-setting time-dependent searches are only exact under FIFO.
+   Profiles are tied to the graph version they were built for.
+*/
+class TravelTimeProfiles {
+public:
+    struct Point { float time, travel; };
+
+    TravelTimeProfiles() = default;
+    // rows may come in any order; rows on an undirected graph apply to u->v and v->u.
+    // Times are taken modulo period. Fails (with a message on stderr) on a FIFO
+    // violation, duplicate breakpoint times or a missing edge.
+    bool build(const Graph &g, std::vector<ProfileRow> rows, int metric = 0, double period = 86400.0);
+    // CSV rows `u,v,time,travel_time` with external ids (header optional), one line per breakpoint
+    bool load_csv(const std::string &path, const Graph &g, int metric = 0, double period = 86400.0);
+
+    bool empty() const { return profiled == 0; }
+    int metric() const { return metric_; }
+    double period() const { return period_; }
+    uint64_t graph_version() const { return version_; }
+    size_t num_profiled_edges() const { return profiled; }
+    size_t num_points() const { return points.size(); }
+    size_t bytes() const { return first.size() * sizeof(uint32_t) + points.size() * sizeof(Point); }
+    // smallest travel time / km over all edges and times: scales haversine_km into an admissible A* bound
+    double geo_scale() const { return geo_scale_; }
+
+    // t folded into [0, period)
+    double time_of_day(double t) const { return t - period_ * std::floor(t / period_); }
+    // travel time of edge position i (CSR order) entered at time t; static_w when it has no profile
+    double travel_time(size_t i, double t, double static_w) const { return travel_time_of_day(i, time_of_day(t), static_w); }
+    // same with tau = time_of_day(t), for callers relaxing several edges at one time
+    double travel_time_of_day(size_t i, double tau, double static_w) const {
+        if (first.empty() || first[i] == first[i+1]) return static_w;
+        const Point *b = points.data() + first[i], *e = points.data() + first[i+1];
+        if (e - b == 1) return b->travel;
+        const Point *hi = b;
+        while (hi != e && hi->time <= tau) ++hi;  // profiles are short: a linear scan beats bisection
+        const Point *lo;
+        double t_lo, t_hi;
+        if (hi == b) { lo = e - 1; t_lo = lo->time - period_; t_hi = hi->time; }
+        else if (hi == e) { lo = e - 1; hi = b; t_lo = lo->time; t_hi = hi->time + period_; }
+        else { lo = hi - 1; t_lo = lo->time; t_hi = hi->time; }
+        return lo->travel + (tau - t_lo) / (t_hi - t_lo) * (hi->travel - lo->travel);
+    }
+
+private:
+    int metric_ = 0;
+    double period_ = 86400.0;
+    uint64_t version_ = 0;
+    size_t profiled = 0;
+    double geo_scale_ = 0.0;
+    std::vector<uint32_t> first;   // num_edges()+1 offsets into points, empty when nothing is profiled
+    std::vector<Point> points;     // grouped by edge, sorted by time
+};
+
+#endif // TIME_PROFILES_H